@@ -0,0 +1,363 @@
+#include "../headers/generator.h"
+#include "../headers/propagate.h"
+#include "../headers/solver.h"
+#include "../headers/variant.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * Benchmark suite (make bench). Times the Sudoku hot paths over fixed-seed generated corpora
+ * and a set of well-known hard puzzles and prints the results as JSON on stdout:
+ * ns/op, latency percentiles and, for the searches, node counts.
+*/
+
+static const unsigned int CORPUS_SEED = 20240101;
+static const int CORPUS_SIZE = 200;
+
+// Well-known hard puzzles: Inkala (2012), Norvig's hardest, Easter Monster and 17 clue puzzles
+static const char *HARD_PUZZLES[] = {
+    "800000000003600000070090200050007000000045700000100030001000068008500010090000400",
+    "..53.....8......2..7..1.5..4....53...1..7...6..32...8..6.5....9..4....3......97..",
+    "1.......2.9.4...5...6...7...5.9.3.......7.......85..4.7.....6...3...9.8...2.....1",
+    "12.3....435....1....4........54..2..6...7.........8.9...31..5.......9.7.....6...8",
+    "4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+    "52...6.........7.13...........4..8..6......5...........418.........3..2...87.....",
+    "6.....8.3.4.7.................5.4.7.3..2.....1.6.......2.....5.....8.6......1....",
+    "48.3............71.2.......7.5....6....2..8.............1.76...3.....4......5....",
+    "....14....3....2...7..........9...3.6.1.............8.2.....1.4....5.6.....7.8...",
+    "......52..8.4......3...9...5.1...6..2..7........3.....6...1..........7.4.......3."
+};
+
+// Irregular regions for the jigsaw benchmarks: the boxes with a few cells traded between them
+static const char *JIGSAW_REGIONS = "111222333111222333115422533442153666444555666448559866777486599777888999777888999";
+
+// Cages covering the whole board for the killer benchmarks, with their sums
+static const char *KILLER_CAGES = "ABBBCCDEEFFGHIJDKLMMGIIJNKLMMGIOONNLPPPOOQQRSTTUVVQRRSTWXYYZaRSbWXYcdaeebbffddghh:"
+    "7,11,7,12,12,17,14,3,22,15,11,10,21,7,20,11,15,16,23,12,3,10,11,13,22,4,10,18,7,10,7,3,9,12";
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result {
+    std::string name;
+    std::string corpus;
+    long ops;
+    double nsPerOp;
+    std::vector <double> samples;   // ns per sample, one sample per puzzle
+    std::vector <long> nodes;       // Search nodes per puzzle, empty when not applicable
+};
+
+static double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static double percentile(std::vector <double> sorted, double p) {
+    if(sorted.empty()) return 0;
+    std::sort(sorted.begin(), sorted.end());
+    size_t index = (size_t) (p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void printResult(const Result &result, bool last) {
+    printf("    {\"name\": \"%s\", \"corpus\": \"%s\", \"ops\": %ld, \"ns_per_op\": %.1f",
+        result.name.c_str(), result.corpus.c_str(), result.ops, result.nsPerOp);
+
+    if(!result.samples.empty()) {
+        printf(", \"p50_ns\": %.0f, \"p90_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f",
+            percentile(result.samples, 0.5), percentile(result.samples, 0.9),
+            percentile(result.samples, 0.99), percentile(result.samples, 1.0));
+    }
+
+    if(!result.nodes.empty()) {
+        long sum = 0, max = 0;
+        for(size_t i = 0; i < result.nodes.size(); i++) {
+            sum += result.nodes[i];
+            if(result.nodes[i] > max) max = result.nodes[i];
+        }
+        printf(", \"nodes_avg\": %.1f, \"nodes_max\": %ld", (double) sum / result.nodes.size(), max);
+    }
+
+    printf("}%s\n", last ? "" : ",");
+}
+
+/**
+ * --------------------------- BENCHMARKS ---------------------------
+*/
+
+static Result benchIsSafe(const std::string &corpusName, std::vector <Sudoku> &corpus) {
+    Result result;
+    result.name = "isSafe";
+    result.corpus = corpusName;
+
+    const int rounds = 20;
+    long safe = 0;
+    Clock::time_point start = Clock::now();
+    for(int round = 0; round < rounds; round++) {
+        for(size_t i = 0; i < corpus.size(); i++) {
+            for(int cell = 0; cell < 81; cell++) {
+                for(int number = 1; number <= 9; number++) {
+                    safe += corpus[i].isSafe(cell / 9, cell % 9, number);
+                }
+            }
+        }
+    }
+    result.ops = (long) rounds * corpus.size() * 81 * 9;
+    result.nsPerOp = elapsedNs(start) / result.ops;
+
+    // Keeps the calls from being optimized away
+    if(safe < 0) printf("%ld", safe);
+    return result;
+}
+
+static Result benchCountBlank(const std::string &corpusName, std::vector <Sudoku> &corpus) {
+    Result result;
+    result.name = "countBlank";
+    result.corpus = corpusName;
+
+    const int rounds = 200;
+    long blank = 0;
+    Clock::time_point start = Clock::now();
+    for(int round = 0; round < rounds; round++) {
+        for(size_t i = 0; i < corpus.size(); i++) {
+            blank += corpus[i].countBlank();
+        }
+    }
+    result.ops = (long) rounds * corpus.size();
+    result.nsPerOp = elapsedNs(start) / result.ops;
+
+    if(blank < 0) printf("%ld", blank);
+    return result;
+}
+
+static Result benchSolve(const std::string &corpusName, std::vector <Sudoku> &corpus, Solver &solver) {
+    Result result;
+    result.name = std::string("solve/") + solver.getName();
+    result.corpus = corpusName;
+    result.ops = corpus.size();
+
+    double total = 0;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        Sudoku sudoku = corpus[i];
+
+        Clock::time_point start = Clock::now();
+        solver.solve(sudoku);
+        double ns = elapsedNs(start);
+
+        total += ns;
+        result.samples.push_back(ns);
+        if(std::string(solver.getName()) == "backtracking") {
+            result.nodes.push_back(sudoku.getSearchNodes());
+        }
+    }
+    result.nsPerOp = total / result.ops;
+    return result;
+}
+
+static Result benchCountSolutions(const std::string &corpusName, std::vector <Sudoku> &corpus) {
+    Result result;
+    result.name = "countSolutions(2)";
+    result.corpus = corpusName;
+    result.ops = corpus.size();
+
+    double total = 0;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        Clock::time_point start = Clock::now();
+        corpus[i].countSolutions(2);
+        double ns = elapsedNs(start);
+
+        total += ns;
+        result.samples.push_back(ns);
+        result.nodes.push_back(corpus[i].getSearchNodes());
+    }
+    result.nsPerOp = total / result.ops;
+    return result;
+}
+
+static Result benchGenerateSudoku(int level, std::vector <Sudoku> &solutions) {
+    Result result;
+    result.name = "generateSudoku";
+    result.corpus = std::string("solved/level") + (char) ('0' + level);
+    result.ops = solutions.size();
+
+    Random random(CORPUS_SEED + level);
+    double total = 0;
+    for(size_t i = 0; i < solutions.size(); i++) {
+        Sudoku sudoku = solutions[i];
+
+        Clock::time_point start = Clock::now();
+        sudoku.generateSudoku(level, random);
+        double ns = elapsedNs(start);
+
+        total += ns;
+        result.samples.push_back(ns);
+    }
+    result.nsPerOp = total / result.ops;
+    return result;
+}
+
+static Result benchGeneratePuzzle(int level, int count) {
+    Result result;
+    result.name = "generatePuzzle";
+    result.corpus = std::string("level") + (char) ('0' + level);
+    result.ops = count;
+
+    double total = 0;
+    for(int i = 0; i < count; i++) {
+        Clock::time_point start = Clock::now();
+        generatePuzzle(level, CORPUS_SEED + i);
+        double ns = elapsedNs(start);
+
+        total += ns;
+        result.samples.push_back(ns);
+    }
+    result.nsPerOp = total / result.ops;
+    return result;
+}
+
+// Solves 81 character puzzles with the rule engine
+static Result benchVariantSolve(const std::string &rulesName, const std::string &corpusName, const RuleTables &rules, std::vector <std::string> &corpus) {
+    Result result;
+    result.name = "solve/rules-" + rulesName;
+    result.corpus = corpusName;
+    result.ops = corpus.size();
+
+    double total = 0;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        VariantSudoku sudoku(rules);
+        sudoku.loadString(corpus[i].c_str());
+
+        Clock::time_point start = Clock::now();
+        sudoku.solve();
+        double ns = elapsedNs(start);
+
+        total += ns;
+        result.samples.push_back(ns);
+        result.nodes.push_back(sudoku.getSearchNodes());
+    }
+    result.nsPerOp = total / result.ops;
+    return result;
+}
+
+// Generates count puzzles of the level with the rule engine and keeps them in corpus
+static Result benchVariantGenerate(const std::string &rulesName, const RuleTables &rules, int level, int count, std::vector <std::string> &corpus) {
+    Result result;
+    result.name = "generate/rules-" + rulesName;
+    result.corpus = std::string("level") + (char) ('0' + level);
+    result.ops = count;
+
+    char line[82];
+    line[81] = '\0';
+
+    double total = 0;
+    for(int i = 0; i < count; i++) {
+        VariantSudoku puzzle(rules), solution(rules);
+
+        Clock::time_point start = Clock::now();
+        bool generated = generateVariantPuzzle(rules, level, CORPUS_SEED + i, puzzle, solution);
+        double ns = elapsedNs(start);
+
+        total += ns;
+        result.samples.push_back(ns);
+        if(!generated) continue;    // Solving an empty board would say nothing about the puzzles
+        puzzle.writeString(line);
+        corpus.push_back(line);
+    }
+    result.nsPerOp = total / result.ops;
+    return result;
+}
+
+int main(int argc, char * argv[]) {
+    Solver *backtracking = createSolver("backtracking");
+    Solver *dlx = createSolver("dlx");
+
+    // Fixed-seed corpora, the same puzzles on every run
+    std::vector <Sudoku> levels[3];
+    std::vector <Sudoku> solutions;
+    for(int level = 0; level < 3; level++) {
+        for(int i = 0; i < CORPUS_SIZE; i++) {
+            Puzzle puzzle = generatePuzzle(level, CORPUS_SEED + i);
+            levels[level].push_back(puzzle.puzzle);
+            if(level == 0) solutions.push_back(puzzle.solution);
+        }
+    }
+
+    std::vector <Sudoku> hard;
+    for(size_t i = 0; i < sizeof(HARD_PUZZLES) / sizeof(HARD_PUZZLES[0]); i++) {
+        int grid[9][9] = {{0}};
+        Sudoku sudoku(grid);
+        sudoku.loadString(HARD_PUZZLES[i]);
+        hard.push_back(sudoku);
+    }
+
+    const char *names[3] = {"easy", "medium", "hard"};
+    std::vector <Result> results;
+
+    for(int level = 0; level < 3; level++) {
+        results.push_back(benchIsSafe(names[level], levels[level]));
+    }
+    results.push_back(benchCountBlank("easy", levels[0]));
+
+    for(int level = 0; level < 3; level++) {
+        results.push_back(benchSolve(names[level], levels[level], *backtracking));
+        results.push_back(benchSolve(names[level], levels[level], *dlx));
+        results.push_back(benchCountSolutions(names[level], levels[level]));
+    }
+    results.push_back(benchSolve("well-known-hard", hard, *backtracking));
+    results.push_back(benchSolve("well-known-hard", hard, *dlx));
+    results.push_back(benchCountSolutions("well-known-hard", hard));
+
+    for(int level = 0; level < 3; level++) {
+        results.push_back(benchGenerateSudoku(level, solutions));
+    }
+    for(int level = 0; level < 3; level++) {
+        results.push_back(benchGeneratePuzzle(level, 50));
+    }
+
+    // The classic rules through the rule engine against the built-in search, then variants
+    const char *specs[4][2] = {{"classic", ""}, {"x", ""}, {"jigsaw", JIGSAW_REGIONS}, {"killer", KILLER_CAGES}};
+    RuleTables tables[4];
+    for(int i = 0; i < 4; i++) {
+        Rules rules;
+        std::string error, spec = std::string(specs[i][0]) + (specs[i][1][0] != '\0' ? std::string(":") + specs[i][1] : "");
+        if(!parseRules(spec, rules, error) || !tables[i].compile(rules, error)) {
+            fprintf(stderr, "Bad %s rules: %s\n", specs[i][0], error.c_str());
+            return 1;
+        }
+    }
+
+    for(int level = 0; level < 3; level++) {
+        std::vector <std::string> corpus;
+        char line[82];
+        line[81] = '\0';
+        for(size_t i = 0; i < levels[level].size(); i++) {
+            levels[level][i].writeString(line);
+            corpus.push_back(line);
+        }
+        results.push_back(benchVariantSolve("classic", names[level], tables[0], corpus));
+    }
+    std::vector <std::string> hardCorpus(HARD_PUZZLES, HARD_PUZZLES + sizeof(HARD_PUZZLES) / sizeof(HARD_PUZZLES[0]));
+    results.push_back(benchVariantSolve("classic", "well-known-hard", tables[0], hardCorpus));
+    for(int i = 0; i < 4; i++) {
+        std::vector <std::string> corpus;
+        results.push_back(benchVariantGenerate(specs[i][0], tables[i], 2, 50, corpus));
+        results.push_back(benchVariantSolve(specs[i][0], "generated/level2", tables[i], corpus));
+    }
+
+    printf("{\n");
+    printf("  \"corpus_seed\": %u,\n", CORPUS_SEED);
+    printf("  \"corpus_size\": %d,\n", CORPUS_SIZE);
+    printf("  \"propagate_kernel\": \"%s\",\n", getPropagateKernel());
+    printf("  \"benchmarks\": [\n");
+    for(size_t i = 0; i < results.size(); i++) {
+        printResult(results[i], i + 1 == results.size());
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    delete backtracking;
+    delete dlx;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "../headers/canonical.h"
+#include "../headers/generator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * Checks canonicalForm against a brute force search over all 2 x 6^8 transforms (relabeling
+ * follows from the others: the smallest labels come in order of first appearance), and that
+ * random transforms of a board all give its canonical form, over a fixed-seed corpus of
+ * generated puzzles, their grids and boards with many symmetries. Exits with 1 on a mismatch.
+*/
+
+static const uint8_t ORDERS_OF_3[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+
+// Reference: every transform, numbers relabeled by first appearance, the smallest board kept
+static void canonicalByBruteForce(const Sudoku &sudoku, uint8_t best[81]) {
+    uint8_t grids[2][9][9];
+    for(int i = 0; i < 9; i++) {
+        for(int j = 0; j < 9; j++) {
+            grids[0][i][j] = sudoku.getItem(i, j);
+            grids[1][j][i] = sudoku.getItem(i, j);
+        }
+    }
+    memset(best, 0xFF, 81);
+
+    // All orders of the rows within bands and bands, the same for columns
+    static const int DIVISORS[3] = {36, 6, 1};
+    uint8_t orders[1296][9];
+    for(int i = 0; i < 1296; i++) {
+        const uint8_t *outer = ORDERS_OF_3[i / 216];
+        for(int k = 0; k < 3; k++) {
+            const uint8_t *inner = ORDERS_OF_3[i / DIVISORS[k] % 6];
+            for(int n = 0; n < 3; n++) orders[i][k * 3 + n] = outer[k] * 3 + inner[n];
+        }
+    }
+
+    for(int t = 0; t < 2; t++) {
+        for(int r = 0; r < 1296; r++) {
+            for(int c = 0; c < 1296; c++) {
+                uint8_t labels[10] = {0};
+                int lastDigit = 0;
+                bool smaller = false;
+
+                for(int cell = 0; cell < 81; cell++) {
+                    int number = grids[t][orders[r][cell / 9]][orders[c][cell % 9]];
+                    if(number != 0 && labels[number] == 0) labels[number] = ++lastDigit;
+
+                    int label = labels[number];
+                    if(!smaller) {
+                        if(label > best[cell]) break;
+                        if(label < best[cell]) smaller = true;
+                    }
+                    if(smaller) best[cell] = label;
+                }
+            }
+        }
+    }
+}
+
+static bool sameBoard(const Sudoku &sudoku, const uint8_t cells[81]) {
+    for(int cell = 0; cell < 81; cell++) {
+        if(sudoku.getItem(cell / 9, cell % 9) != cells[cell]) return false;
+    }
+    return true;
+}
+
+static bool sameBoard(const Sudoku &a, const Sudoku &b) {
+    for(int cell = 0; cell < 81; cell++) {
+        if(a.getItem(cell / 9, cell % 9) != b.getItem(cell / 9, cell % 9)) return false;
+    }
+    return true;
+}
+
+static void printBoard(const char *name, const Sudoku &sudoku) {
+    char text[82];
+    text[81] = '\0';
+    Sudoku copy = sudoku;
+    copy.writeString(text);
+    printf("  %-10s %s\n", name, text);
+}
+
+static Sudoku loadBoard(const char *text) {
+    Sudoku sudoku;
+    sudoku.loadString(text);
+    return sudoku;
+}
+
+int main(int argc, char * argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000;
+    int bruteForce = argc > 2 ? atoi(argv[2]) : 12;
+
+    // Boards whose transforms tie a lot, where pruning and skipping identical rows matter most
+    std::vector <Sudoku> corpus;
+    corpus.push_back(loadBoard("000000000000000000000000000000000000000000000000000000000000000000000000000000000"));
+    corpus.push_back(loadBoard("000000000000000000000000000000050000000000000000000000000000000000000000000000000"));
+    corpus.push_back(loadBoard("123456789456789123789123456234567891567891234891234567345678912678912345912345678"));
+    corpus.push_back(loadBoard("100000000000100000000000100010000000000010000000000010001000000000001000000000001"));
+    corpus.push_back(loadBoard("120000000000120000000000120000000000000000000000000000000000000000000000000000000"));
+    corpus.push_back(loadBoard("000000010400000000020000000000050407008000300001090000300400200050100000000806000"));
+    int fixed = corpus.size();
+
+    for(int i = 0; i < count; i++) {
+        Puzzle puzzle = generatePuzzle(i % 3, 4242 + i);
+        corpus.push_back(i % 2 == 0 ? puzzle.puzzle : puzzle.solution);
+    }
+
+    int failures = 0;
+
+    // Brute force is about a second per board, so only the fixed boards and a few generated ones
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int checked = 0;
+    for(int i = 0; i < (int) corpus.size() && i < fixed + bruteForce; i++, checked++) {
+        uint8_t best[81];
+        canonicalByBruteForce(corpus[i], best);
+
+        Sudoku canonical = canonicalForm(corpus[i]);
+        if(!sameBoard(canonical, best)) {
+            printf("Board %d isn't the smallest transform\n", i);
+            printBoard("board", corpus[i]);
+            printBoard("canonical", canonical);
+            failures++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-14s %6d boards in %.1f s\n", "brute force", checked, seconds);
+
+    // The transform found has to lead to the form, and every random transform back to it
+    Random random(99);
+    int transforms = 0;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        Transform transform;
+        Sudoku canonical = canonicalForm(corpus[i], &transform);
+        if(!sameBoard(applyTransform(corpus[i], transform), canonical)) {
+            printf("Board %zu: the transform doesn't give the canonical form\n", i);
+            failures++;
+        }
+
+        for(int k = 0; k < 8; k++, transforms++) {
+            Sudoku moved = applyTransform(corpus[i], randomTransform(random));
+            if(!sameBoard(canonicalForm(moved), canonical) || canonicalHash(moved) != canonicalHash(corpus[i])) {
+                printf("Board %zu: a transform of it has another canonical form\n", i);
+                printBoard("board", corpus[i]);
+                printBoard("moved", moved);
+                failures++;
+                break;
+            }
+        }
+    }
+    printf("%-14s %6d transforms of %zu boards\n", "invariance", transforms, corpus.size());
+
+    // Rate of the hash alone, grids and puzzles apart
+    for(int kind = 0; kind < 2; kind++) {
+        std::vector <Sudoku> boards;
+        for(size_t i = fixed + kind; i < corpus.size(); i += 2) boards.push_back(corpus[i]);
+
+        uint64_t sum = 0;
+        start = std::chrono::steady_clock::now();
+        for(int repeat = 0; repeat < 10; repeat++) {
+            for(size_t i = 0; i < boards.size(); i++) sum += canonicalHash(boards[i]);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("%-14s %10.0f boards/s (%.0f ns, checksum %llx)\n", kind == 0 ? "hash puzzles" : "hash grids",
+            boards.size() * 10 * 1e9 / ns, ns / (boards.size() * 10), (unsigned long long) sum);
+    }
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
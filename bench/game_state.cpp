@@ -0,0 +1,145 @@
+#include "../headers/game_state.h"
+#include "../headers/generator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * Plays random moves, undos and redos on GameState without a terminal and checks every cell
+ * against the same answers worked out by scanning the board: the numbers shown, isWrong,
+ * isConflict and isWon. Every game ends by filling in the solution, which has to win, and
+ * undoing every move, which has to give back the puzzle. Exits with 1 on a mismatch.
+*/
+
+// Reference: the board the moves so far should have left, scanned in full
+struct ScanBoard {
+    int value[81];
+    int solution[81];
+    bool given[81];
+
+    bool isConflict(int cell) const {
+        int number = this->value[cell];
+        if(number == 0) return false;
+
+        int row = cell / 9, col = cell % 9;
+        for(int other = 0; other < 81; other++) {
+            if(other == cell || this->value[other] != number) continue;
+            int otherRow = other / 9, otherCol = other % 9;
+            if(otherRow == row || otherCol == col || (otherRow / 3 == row / 3 && otherCol / 3 == col / 3)) return true;
+        }
+        return false;
+    }
+
+    bool isWon() const {
+        for(int cell = 0; cell < 81; cell++) {
+            if(this->value[cell] != this->solution[cell]) return false;
+        }
+        return true;
+    }
+};
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool matches(GameState &game, const ScanBoard &board) {
+    for(int cell = 0; cell < 81; cell++) {
+        int row = cell / 9, col = cell % 9;
+        if(game.getItem(row, col) != board.value[cell]) return false;
+        if(game.isGiven(row, col) != board.given[cell]) return false;
+        if(game.isWrong(row, col) != (board.value[cell] != 0 && board.value[cell] != board.solution[cell])) return false;
+        if(game.isConflict(row, col) != board.isConflict(cell)) return false;
+    }
+    return game.isWon() == board.isWon();
+}
+
+int main(int argc, char * argv[]) {
+    int games = argc > 1 ? atoi(argv[1]) : 50;
+    int moves = 2000;
+
+    Random random(777);
+    int failures = 0;
+    long operations = 0;
+    double totalNs = 0;
+
+    for(int i = 0; i < games && failures == 0; i++) {
+        Puzzle puzzle = generatePuzzle(i % 3, 31337 + i);
+        GameState game(puzzle.puzzle, puzzle.solution);
+
+        ScanBoard board;
+        for(int cell = 0; cell < 81; cell++) {
+            board.value[cell] = puzzle.puzzle.getItem(cell / 9, cell % 9);
+            board.solution[cell] = puzzle.solution.getItem(cell / 9, cell % 9);
+            board.given[cell] = board.value[cell] != 0;
+        }
+
+        // The reference journal: boards before every applied move, and the undone ones to redo
+        std::vector <ScanBoard> done, undone;
+        int mistakes = 0;
+
+        for(int k = 0; k < moves + 81 && failures == 0; k++) {
+            int action = k < moves ? random.below(10) : 9;
+            bool changed, expected;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if(action == 0) {
+                changed = game.undo();
+                totalNs += elapsedNs(start);
+                expected = !done.empty();
+                if(expected) {
+                    undone.push_back(board);
+                    board = done.back();
+                    done.pop_back();
+                }
+            } else if(action == 1) {
+                changed = game.redo();
+                totalNs += elapsedNs(start);
+                expected = !undone.empty();
+                if(expected) {
+                    done.push_back(board);
+                    board = undone.back();
+                    undone.pop_back();
+                }
+            } else {
+                // Random numbers, the tail of every game fills in the solution
+                int cell = k < moves ? random.below(81) : k - moves;
+                int number = k < moves ? random.below(10) : board.solution[cell];
+                start = std::chrono::steady_clock::now();
+                changed = game.setItem(cell / 9, cell % 9, number);
+                totalNs += elapsedNs(start);
+                expected = !board.given[cell] && board.value[cell] != number;
+                if(expected) {
+                    done.push_back(board);
+                    undone.clear();
+                    board.value[cell] = number;
+                    if(number != 0 && number != board.solution[cell]) mistakes++;
+                }
+            }
+            operations++;
+
+            if(changed != expected || !matches(game, board) || game.getMistakes() != mistakes) {
+                printf("Game %d, move %d (action %d): the state doesn't match the board\n", i, k, action);
+                failures++;
+            }
+        }
+
+        if(failures == 0 && !game.isWon()) {
+            printf("Game %d: filling in the solution didn't win\n", i);
+            failures++;
+        }
+
+        // Undoing everything gives the puzzle back
+        while(game.undo()) {}
+        for(int cell = 0; cell < 81 && failures == 0; cell++) {
+            if(game.getItem(cell / 9, cell % 9) != puzzle.puzzle.getItem(cell / 9, cell % 9)) {
+                printf("Game %d: undoing every move didn't give back the puzzle\n", i);
+                failures++;
+            }
+        }
+    }
+
+    printf("%-10s %8ld moves, undos and redos in %d games, %.0f ns each\n", "game state", operations, games, totalNs / operations);
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+#include "../headers/propagate.h"
+#include "../headers/generator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * Compares the propagation kernels with the same singles propagation written on top of
+ * Sudoku::isSafe, over a fixed-seed corpus of generated puzzles.
+*/
+
+// Reference: candidates from isSafe, naked and hidden singles until nothing changes
+static int propagateWithIsSafe(Sudoku &sudoku) {
+    int total = 0;
+
+    while(1) {
+        int candidates[9][9];
+        int filled = 0;
+
+        for(int r = 0; r < 9; r++) {
+            for(int c = 0; c < 9; c++) {
+                candidates[r][c] = 0;
+                if(sudoku.getItem(r, c) != 0) continue;
+
+                for(int number = 1; number <= 9; number++) {
+                    if(sudoku.isSafe(r, c, number)) candidates[r][c] |= 1 << (number - 1);
+                }
+                if(candidates[r][c] == 0) return -1;
+            }
+        }
+
+        for(int r = 0; r < 9; r++) {
+            for(int c = 0; c < 9; c++) {
+                int mask = candidates[r][c];
+                if(mask != 0 && (mask & (mask - 1)) == 0 && sudoku.isSafe(r, c, __builtin_ctz(mask) + 1)) {
+                    sudoku.setItem(r, c, __builtin_ctz(mask) + 1);
+                    filled++;
+                }
+            }
+        }
+
+        for(int unit = 0; unit < 27; unit++) {
+            for(int number = 1; number <= 9; number++) {
+                int count = 0, row = 0, col = 0;
+                for(int k = 0; k < 9; k++) {
+                    int r, c;
+                    if(unit < 9) { r = unit; c = k; }
+                    else if(unit < 18) { r = k; c = unit - 9; }
+                    else { r = ((unit - 18) / 3) * 3 + k / 3; c = ((unit - 18) % 3) * 3 + k % 3; }
+
+                    if(candidates[r][c] & (1 << (number - 1))) {
+                        count++;
+                        row = r;
+                        col = c;
+                    }
+                }
+                if(count == 1 && sudoku.getItem(row, col) == 0 && sudoku.isSafe(row, col, number)) {
+                    sudoku.setItem(row, col, number);
+                    filled++;
+                }
+            }
+        }
+
+        if(filled == 0) return total;
+        total += filled;
+    }
+}
+
+static double measure(std::vector <Sudoku> &corpus, bool reference, int rounds, long &filled) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    filled = 0;
+
+    for(int round = 0; round < rounds; round++) {
+        for(size_t i = 0; i < corpus.size(); i++) {
+            Sudoku sudoku = corpus[i];
+            int result = reference ? propagateWithIsSafe(sudoku) : propagateSingles(sudoku);
+            if(result > 0) filled += result;
+        }
+    }
+
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / (rounds * corpus.size());
+}
+
+int main(int argc, char * argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 300;
+    int rounds = 20;
+
+    std::vector <Sudoku> corpus;
+    for(int i = 0; i < count; i++) {
+        corpus.push_back(generatePuzzle(i % 3, 12345 + i).puzzle);
+    }
+
+    long filled;
+    double reference = measure(corpus, true, rounds, filled);
+    printf("%-8s %10.0f ns/puzzle  %ld cells filled\n", "isSafe", reference, filled / rounds);
+
+    const char *kernels[] = {"scalar", "sse2", "avx2"};
+    for(int i = 0; i < 3; i++) {
+        if(!setPropagateKernel(kernels[i])) {
+            printf("%-8s not supported\n", kernels[i]);
+            continue;
+        }
+        double ns = measure(corpus, false, rounds, filled);
+        printf("%-8s %10.0f ns/puzzle  %ld cells filled  %.1fx\n", kernels[i], ns, filled / rounds, reference / ns);
+    }
+
+    return 0;
+}
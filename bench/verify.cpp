@@ -0,0 +1,90 @@
+#include "../headers/verify.h"
+#include "../headers/generator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * Compares the verification kernels with the same check written on top of getItem and
+ * Sudoku::isSafe, over a fixed-seed corpus of puzzle and solution pairs.
+ * The kernels run through runVerify on a temporary file, so the rate includes reading it.
+*/
+
+// Reference: every cell of the solution must be safe once it's cleared and must keep its given
+static bool verifyWithIsSafe(const Puzzle &pair) {
+    Sudoku solution = pair.solution;
+
+    for(int r = 0; r < 9; r++) {
+        for(int c = 0; c < 9; c++) {
+            int number = solution.getItem(r, c);
+            int given = pair.puzzle.getItem(r, c);
+            if(given != 0 && given != number) return false;
+
+            solution.setItem(r, c, 0);
+            bool safe = number != 0 && solution.isSafe(r, c, number);
+            solution.setItem(r, c, number);
+            if(!safe) return false;
+        }
+    }
+
+    return true;
+}
+
+static std::string boardText(const Sudoku &sudoku) {
+    std::string text;
+    for(int r = 0; r < 9; r++) {
+        for(int c = 0; c < 9; c++) text += (char) ('0' + sudoku.getItem(r, c));
+    }
+    return text;
+}
+
+int main(int argc, char * argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000;
+    int copies = 1000;
+
+    std::vector <Puzzle> corpus;
+    for(int i = 0; i < count; i++) {
+        corpus.push_back(generatePuzzle(i % 3, 12345 + i));
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long valid = 0;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        if(verifyWithIsSafe(corpus[i])) valid++;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%-8s %10.0f boards/s  %ld valid\n", "isSafe", corpus.size() * 1e9 / ns, valid);
+
+    char path[] = "/tmp/sudoku-verify-XXXXXX";
+    int fd = mkstemp(path);
+    FILE *file = fd < 0 ? NULL : fdopen(fd, "w");
+    if(file == NULL) {
+        fprintf(stderr, "Can't create a temporary file\n");
+        return 1;
+    }
+
+    std::string lines;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        lines += boardText(corpus[i].puzzle) + ' ' + boardText(corpus[i].solution) + '\n';
+    }
+    for(int copy = 0; copy < copies; copy++) {
+        fwrite(lines.data(), 1, lines.size(), file);
+    }
+    fclose(file);
+
+    // runVerify reports the rate of every kernel on stderr
+    const char *kernels[] = {"scalar", "ssse3", "avx2"};
+    for(int i = 0; i < 3; i++) {
+        if(!setVerifyKernel(kernels[i])) {
+            printf("%-8s not supported\n", kernels[i]);
+            continue;
+        }
+        fflush(stdout);
+        runVerify(path);
+    }
+
+    remove(path);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef BANK_H
+#define BANK_H
+
+#include <cstdint>
+#include <string>
+#include "generator.h"
+
+/**
+ * Packed puzzle bank file.
+ *
+ * A header followed by the entries of every level, grouped by level (Easy, Medium, Hard).
+ * One entry is 81 bytes: the high nibble of byte i is cell i of the puzzle (0 for blank),
+ * the low nibble cell i of the solution. Entries are only ever read through a read-only
+ * memory mapping, so picking one needs no copying and no parsing.
+*/
+struct BankHeader {
+    char magic[4];          // "SDKB"
+    uint32_t version;
+    uint32_t entrySize;
+    uint32_t levels;
+    uint64_t offset[3];     // File offset of the first entry of every level
+    uint64_t count[3];      // Number of entries of every level
+};
+
+class PuzzleBank {
+private:
+    const unsigned char *data;
+    size_t size;
+    const BankHeader *header;
+    Random random;
+public:
+    PuzzleBank();
+    ~PuzzleBank();
+    // Maps the bank file and checks its header in constant time, returns false (and prints why to
+    // stderr) when it isn't a valid bank. Entries are only checked when they are picked
+    bool open(const std::string &path);
+    long getCount(int level);
+    // Pointer into the mapping, valid as long as the bank is open
+    const unsigned char* getEntry(int level, long index);
+    long getRandomIndex(int level);
+    // False when the entry is damaged (see isValidBankEntry)
+    bool getPuzzle(int level, long index, Puzzle &puzzle);
+    // False when a few random picks in a row were all damaged
+    bool getRandomPuzzle(int level, Puzzle &puzzle);
+};
+
+// Packs a puzzle and its solution into one entry
+void encodeBankEntry(Puzzle &puzzle, unsigned char *entry);
+// True when the solution nibbles form a valid grid and every puzzle nibble is 0 or the solution's number
+bool isValidBankEntry(const unsigned char *entry);
+Puzzle decodeBankEntry(const unsigned char *entry);
+
+/**
+ * sudoku --build-bank FILE --count N: generates N puzzles per level on a thread pool
+ * and writes them to a bank file. Puzzle i of a level is generated from seed + i, so the
+ * same seed builds the same puzzles (in the order the workers finish them).
+ * Returns the process exit code.
+*/
+int runBuildBank(const std::string &path, long count, int threads, uint64_t seed);
+
+/**
+ * sudoku --bank-sample FILE --level L --count N: prints N random puzzles of a level from the bank,
+ * one 81 character line each, e.g. as input for --solve. Returns the process exit code.
+*/
+int runBankSample(const std::string &path, int level, long count);
+
+#endif
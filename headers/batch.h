@@ -0,0 +1,24 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include "rules.h"
+#include "solver.h"
+#include "stats.h"
+
+/**
+ * Headless batch solving (sudoku --solve FILE).
+ * Reads one 81 character puzzle per line from path ("-" for stdin), solves them on a thread pool
+ * and writes the solutions to stdout in input order. Lines that can't be parsed are answered
+ * with "invalid", puzzles without a solution with "unsolvable".
+ * Lines of 16, 256 or 625 characters are read as 4x4, 16x16 or 25x25 boards (see loadString).
+ * Puzzles the search gives up on within the budget (see solveBounded) are answered with "budget",
+ * a budget with a solver that can't stop early (see isBounded) is an error unless rules are given.
+ * When report isn't NULL every puzzle's counters and latency are added to it in input order.
+ * When rules isn't NULL every puzzle is a 9x9 board solved by those rules (see VariantSudoku)
+ * instead of the solver, which only knows the classic ones. The budget applies to them as well.
+ * Returns the process exit code.
+*/
+int runBatchSolve(const std::string &path, const std::string &solverName, int threads, const SearchBudget &budget, StatsReport *report, const RuleTables *rules);
+
+#endif
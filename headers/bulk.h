@@ -0,0 +1,20 @@
+#ifndef BULK_H
+#define BULK_H
+
+#include <cstdint>
+#include "rules.h"
+#include "stats.h"
+
+/**
+ * Bulk puzzle generation (sudoku --generate N --level L).
+ * The workers of a work-stealing pool generate puzzles, duplicates are dropped (by a hash set
+ * that grows with the puzzles and is split into shards with a lock each) and the unique
+ * puzzles are written to stdout (one 81 character line each) as soon as they are produced.
+ * Puzzle i is generated from seed + i, so the same seed gives the same puzzles, only the order
+ * depends on the workers. When report isn't NULL every generated puzzle (duplicates included)
+ * is added to it. When rules isn't NULL the puzzles are made for those rules (see
+ * generateVariantPuzzle). Returns the process exit code.
+*/
+int runBulkGenerate(long count, int level, int threads, uint64_t seed, StatsReport *report, const RuleTables *rules);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include "random.h"
+#include "sudoku.h"
+
+/**
+ * Validity preserving transform of a 9x9 board: optional transposition, then output row i is
+ * source row rows[i] and output column j source column cols[j], then every number n becomes
+ * digits[n] (digits[0] stays 0). rows / cols only ever move rows within their band and whole
+ * bands (columns and stacks alike).
+*/
+struct Transform {
+    bool transpose;
+    uint8_t rows[9];
+    uint8_t cols[9];
+    uint8_t digits[10];
+};
+
+Sudoku applyTransform(const Sudoku &sudoku, const Transform &transform);
+
+// Picks every part of a transform uniformly: transposition, band, row, stack, column and digit order
+Transform randomTransform(Random &random);
+
+/**
+ * Canonical form: the smallest board, read row by row with 0 before every number, among all
+ * transforms of the board. Boards that are the same up to relabeling, band / stack / row / column
+ * permutation and transposition get the same canonical form. The search builds the result cell by
+ * cell, choosing rows, stacks and columns as it goes, and drops a branch as soon as a cell comes out
+ * larger than in the best board so far. Complete grids only search their second row, the other
+ * rows follow by sorting.
+ * When transform isn't NULL it receives a transform taking the board to its canonical form.
+*/
+Sudoku canonicalForm(const Sudoku &sudoku, Transform *transform = NULL);
+
+// 64-bit hash of the canonical form
+uint64_t canonicalHash(const Sudoku &sudoku);
+
+#endif
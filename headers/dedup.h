@@ -0,0 +1,16 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <string>
+
+/**
+ * Corpus deduplication (sudoku --dedup FILE [--index FILE]).
+ * Reads one 81 character board per line from path ("-" for stdin) and writes every board whose
+ * canonical form (see canonicalForm) wasn't seen before to stdout, in input order.
+ * The canonical hashes are computed on a thread pool and looked up in an in-memory index. With an
+ * index file the index is loaded from it first and saved back at the end, so corpora deduplicated
+ * one after another are also deduplicated against each other. Returns the process exit code.
+*/
+int runDedup(const std::string &path, int threads, const std::string &indexPath);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef DLX_H
+#define DLX_H
+
+#include "solver.h"
+
+/**
+ * Exact cover (Algorithm X / Dancing Links) solver over the 324 sudoku constraints:
+ * every cell filled once, every number once per row, column and box.
+ * The matrix (729 candidate rows, 4 nodes each) is built once in the constructor
+ * and restored after each solve, so no allocation happens per puzzle.
+*/
+class DlxSolver : public Solver {
+private:
+    static const int COLUMNS = 324;
+    static const int ROWS = 729;
+    static const int NODES = 1 + COLUMNS + ROWS * 4;
+    static const int ROOT = 0;
+
+    int left[NODES];
+    int right[NODES];
+    int up[NODES];
+    int down[NODES];
+    int column[NODES];      // Column header of the node
+    int rowId[NODES];       // Candidate row of the node (cell * 9 + number - 1)
+    int size[COLUMNS + 1];
+    int rowStart[ROWS];     // First node of each candidate row
+    bool covered[COLUMNS + 1];
+    int solution[81];
+
+    void cover(int col);
+    void uncover(int col);
+    bool selectRow(int row);
+    void unselectRow(int row);
+    bool search(int depth, int &solvedDepth);
+public:
+    DlxSolver();
+    const char* getName();
+    bool solve(Sudoku &sudoku);
+};
+
+#endif
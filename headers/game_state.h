@@ -0,0 +1,52 @@
+#ifndef GAME_STATE_H
+#define GAME_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "sudoku.h"
+
+/**
+ * State of a game being played, independent of the terminal.
+ * Every change updates the count of correctly filled cells and how often each number occurs
+ * in every row, column and box, so "won?" and "is this cell in conflict?" never scan the board.
+ * Changes are kept in a journal of 3 byte moves for unlimited undo and redo.
+*/
+class GameState {
+private:
+    struct Move {
+        uint8_t cell;
+        uint8_t before;
+        uint8_t after;
+    };
+
+    uint8_t value[81];
+    uint8_t solution[81];
+    bool given[81];
+    uint8_t rowCount[9][10];    // How many cells of a row hold each number
+    uint8_t colCount[9][10];
+    uint8_t boxCount[9][10];
+    int correct;                // Cells holding the number of the solution
+    int mistakes;               // Wrong numbers entered so far, undo doesn't take them back
+    std::vector <Move> journal;
+    size_t position;            // Moves in the journal that are currently applied
+    void apply(int cell, int number);
+public:
+    GameState(const Sudoku &puzzle, const Sudoku &solution);
+    // Starts over with another puzzle, the journal keeps its memory for the next game
+    void reset(const Sudoku &puzzle, const Sudoku &solution);
+    int getItem(int row, int col);
+    bool isGiven(int row, int col);
+    // Wrong compared to the solution
+    bool isWrong(int row, int col);
+    // The number of the cell occurs again in its row, column or box
+    bool isConflict(int row, int col);
+    bool isWon();
+    int getMistakes();
+    // Writes number (0 clears) into a cell that isn't given. Returns false when nothing changed
+    bool setItem(int row, int col, int number);
+    bool undo();
+    bool redo();
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstdint>
+#include "sudoku.h"
+#include "variant.h"
+
+// Fully solved grid together with the puzzle made from it
+struct Puzzle {
+    uint64_t id;            // See makePuzzleId, 0 when the puzzle wasn't generated from a seed
+    Sudoku solution;
+    Sudoku puzzle;
+    Puzzle(uint64_t id, const Sudoku &solution, const Sudoku &puzzle);
+};
+
+// 8 byte puzzle ID: the level in the top 2 bits, the lower 62 bits of the seed below
+uint64_t makePuzzleId(int level, uint64_t seed);
+int getPuzzleLevel(uint64_t id);
+
+// Shuffles one of a table of full grids with a random transform (see randomTransform) and blanks it
+// down to a unique puzzle graded at the given level (0 Easy, 1 Medium, 2 Hard, see gradeSudoku).
+// Puzzles that come out easier are reworked until they reach it, so the level is always met.
+// All randomness comes from the seed, so the same level and seed always give the same puzzle
+Puzzle generatePuzzle(int level, uint64_t seed);
+
+// Generates the puzzle an ID was made for again
+Puzzle regeneratePuzzle(uint64_t id);
+
+// Random full grid of the rules from seed, blanked and reworked down to a unique puzzle of the
+// level like generatePuzzle, graded by the techniques over the units of the rules. Returns false
+// (and leaves the boards as they were) when no full grid was found or a few grids all fell short
+// of the level
+bool generateVariantPuzzle(const RuleTables &rules, int level, uint64_t seed, VariantSudoku &puzzle, VariantSudoku &solution);
+
+#endif
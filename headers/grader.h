@@ -0,0 +1,47 @@
+#ifndef GRADER_H
+#define GRADER_H
+
+#include "sudoku.h"
+#include "variant.h"
+
+// Solving techniques, from the simplest to the hardest
+enum Technique {
+    NAKED_SINGLE,
+    HIDDEN_SINGLE,
+    LOCKED_CANDIDATES,
+    NAKED_PAIR,
+    HIDDEN_PAIR,
+    NAKED_TRIPLE,
+    HIDDEN_TRIPLE,
+    X_WING,
+    SWORDFISH,
+    TECHNIQUE_COUNT
+};
+
+struct Grade {
+    int level;                      // 0 Easy, 1 Medium, 2 Hard, 3 when the techniques alone can't solve it
+                                    // (or grading gave up past maxLevel)
+    int hardest;                    // Hardest technique used, -1 when the board was already full
+    int uses[TECHNIQUE_COUNT];      // How many times every technique was applied
+    bool solved;
+};
+
+// Medium puzzles that need locked candidates or pairs this many times grade Hard
+static const int HARD_MEDIUM_USES = 6;
+
+/**
+ * Solves the board the way a person would, always applying the simplest technique that
+ * makes progress, and grades it by the hardest technique it needed and how often:
+ * singles are Easy, locked candidates and pairs Medium, triples and fish Hard, and so is
+ * a puzzle that needs the Medium techniques HARD_MEDIUM_USES times.
+ * Every technique holds for any solution, so a solved grade (level 0 to 2) also proves the
+ * solution unique. Grading stops as soon as the level goes past maxLevel, leaving it unsolved.
+ * The board itself is not modified. Variant boards are graded by the same techniques over their
+ * units, with killer cages also ruling out the numbers that can't make up their sums.
+*/
+Grade gradeSudoku(Sudoku &sudoku, int maxLevel = 3);
+Grade gradeSudoku(VariantSudoku &sudoku, int maxLevel = 3);
+
+const char* getTechniqueName(int technique);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef HASH_SET_H
+#define HASH_SET_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+/**
+ * Open addressing set of 64-bit hashes that doubles when half full, so it takes memory for the
+ * hashes it holds rather than the ones it might get. It takes no lock.
+*/
+class HashSet {
+private:
+    std::vector <uint64_t> slots;
+    uint64_t mask;
+    long count;
+    void grow();
+public:
+    // Starts with 2^slotBits slots
+    HashSet(int slotBits = 16);
+    // Returns false when the hash was already present
+    bool insert(uint64_t hash);
+    long size() const;
+    // The file is the raw array of hashes, in no particular order
+    bool load(FILE *file);
+    bool save(FILE *file) const;
+};
+
+/**
+ * HashSet split by the top bits of the hash into shards with a lock each, for many threads
+ * inserting at once. Threads only wait for each other when they hit the same shard.
+*/
+class ShardedHashSet {
+private:
+    static const int SHARD_BITS = 6;
+    struct Shard {
+        HashSet hashes;
+        std::mutex lock;
+        Shard() : hashes(10) {}     // 8 KiB a shard until it fills up
+    };
+    Shard shards[1 << SHARD_BITS];
+public:
+    // Returns false when the hash was already present
+    bool insert(uint64_t hash);
+};
+
+#endif
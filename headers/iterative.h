@@ -0,0 +1,61 @@
+#ifndef ITERATIVE_H
+#define ITERATIVE_H
+
+#include <atomic>
+#include "solver.h"
+
+/**
+ * Non-recursive search for any board size, with a node / time budget and a cancel token.
+ * It picks cells like the board's own search (fewest candidates first), but keeps one entry per
+ * choice point on a fixed stack and every filled cell on a trail. Going back to a choice point
+ * empties the cells on the trail above it, forced cells (a single candidate) never get a stack
+ * entry. Both arrays are sized for a full board up front, so a search allocates nothing.
+ * The board passed in is only changed when it gets solved.
+ * count() goes on after a solution as if it were a dead end, until limit solutions were found.
+*/
+template <int BoxN>
+class IterativeSearch {
+public:
+    typedef BasicSudoku<BoxN> Board;
+    typedef typename Board::Mask Mask;
+private:
+    static const int CHECK_INTERVAL = 256;  // Nodes between looks at the clock and the cancel token
+
+    struct Choice {
+        int cell;           // row * SIZE + col
+        int trailHeight;    // Trail length before the cell was filled
+        Mask candidates;    // Numbers not tried yet
+    };
+
+    Board work;
+    Choice stack[Board::CELLS];
+    int trail[Board::CELLS];
+    int trailHeight;
+    long nodes;
+    int solutions;
+    void place(int cell, int number);
+    void undoTo(int height);
+    SearchResult run(const Board &board, const SearchBudget &budget, int limit, std::atomic<int> *shared);
+public:
+    SearchResult solve(Board &board, const SearchBudget &budget);
+    // Counts solutions up to limit, SEARCH_SOLVED means the count is final (getSolutions()).
+    // With shared, the solutions of other searches adding to it count towards limit as well
+    SearchResult count(const Board &board, int limit, const SearchBudget &budget, std::atomic<int> *shared = NULL);
+    int getSolutions();
+    // Nodes (filled cells) of the last search
+    long getNodes();
+};
+
+// The 9x9 iterative search as a Solver, solve() runs without a budget
+class IterativeSolver : public Solver {
+private:
+    IterativeSearch<3> search;
+public:
+    const char* getName();
+    bool solve(Sudoku &sudoku);
+    SearchResult solveBounded(Sudoku &sudoku, const SearchBudget &budget);
+    SearchResult countBounded(Sudoku &sudoku, int limit, int &solutions, const SearchBudget &budget);
+    bool isBounded();
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef LINE_PIPELINE_H
+#define LINE_PIPELINE_H
+
+#include <functional>
+#include <future>
+#include <string>
+
+/**
+ * Streams a file of one board per line through a thread pool, for --solve and --dedup.
+ * The file is read in large blocks and cut into chunks of whole lines, work runs on every chunk
+ * on the pool and done gets them back on the calling thread in input order, so it can write
+ * them out. At most 4 chunks per worker are in flight, which bounds the memory held.
+*/
+struct LineChunk {
+    std::string input;      // Whole lines, separated by '\n'
+    std::future<void> done;
+    virtual ~LineChunk() {}
+};
+
+struct LineRun {
+    double seconds;         // From the first read until the last chunk was done
+    int threads;
+    // Items per second over the run
+    double getRate(long count) const;
+};
+
+/**
+ * Runs the pipeline over path ("-" for stdin) with a pool of threads workers, giving stdout a
+ * large buffer. create makes the (derived) chunks, which the pipeline deletes after done.
+ * Returns false with a message on stderr when the file can't be opened.
+*/
+bool runLinePipeline(const std::string &path, int threads, const std::function<LineChunk*()> &create,
+    const std::function<void(LineChunk*)> &work, const std::function<void(LineChunk*)> &done, LineRun &run);
+
+// Calls visit(position, length) for every non-empty line of a chunk, length without the "\r\n"
+template <class Visit>
+void forEachLine(const std::string &input, Visit visit) {
+    size_t position = 0;
+
+    while(position < input.size()) {
+        size_t end = input.find('\n', position);
+        if(end == std::string::npos) end = input.size();
+
+        size_t length = end - position;
+        if(length > 0 && input[end - 1] == '\r') length--;
+        if(length > 0) visit(position, length);
+
+        position = end + 1;
+    }
+}
+
+#endif
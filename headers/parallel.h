@@ -0,0 +1,53 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include "iterative.h"
+#include "thread_pool.h"
+
+// Pool shared by every parallel search, one worker per core
+ThreadPool& getSearchPool();
+
+/**
+ * Search that splits the tree of one puzzle over a work-stealing pool, for hard 9x9 puzzles and
+ * the big sizes. Every puzzle first gets SPLIT_NODES of single-threaded iterative search, which
+ * settles nearly all of them, so easy puzzles never pay for tasks. Only then is the board expanded
+ * breadth first at the cells the search would branch on, until there are a few subtrees per
+ * worker, and every subtree becomes a task for the iterative search. The first task to solve the
+ * puzzle, or to bring the shared count of solutions to the limit, cancels all the others.
+ * The node budget is shared out evenly between the subtrees, the time budget and cancel token
+ * apply to every task.
+*/
+template <int BoxN>
+class ParallelSearch {
+public:
+    typedef BasicSudoku<BoxN> Board;
+    typedef typename Board::Mask Mask;
+private:
+    static const long SPLIT_NODES = 4096;   // About half a millisecond for 9x9
+    static const int TASKS_PER_WORKER = 8;  // Subtrees differ a lot in size, stealing evens them out
+    ThreadPool &pool;
+    int split(const Board &board, int limit, std::vector <Board> &subtrees, Board &solution);
+    SearchResult run(Board &board, int limit, int &solutions, const SearchBudget &budget);
+public:
+    ParallelSearch(ThreadPool &pool);
+    SearchResult solve(Board &board, const SearchBudget &budget);
+    // Counts solutions up to limit (2 tells unique from multiple), SEARCH_SOLVED means the count is final
+    SearchResult count(const Board &board, int limit, int &solutions, const SearchBudget &budget);
+};
+
+// The 9x9 parallel search as a Solver, on the shared pool
+class ParallelSolver : public Solver {
+private:
+    ParallelSearch<3> search;
+public:
+    ParallelSolver();
+    const char* getName();
+    bool solve(Sudoku &sudoku);
+    SearchResult solveBounded(Sudoku &sudoku, const SearchBudget &budget);
+    int countSolutions(Sudoku &sudoku, int limit);
+    SearchResult countBounded(Sudoku &sudoku, int limit, int &solutions, const SearchBudget &budget);
+    bool isBounded();
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef PROPAGATE_H
+#define PROPAGATE_H
+
+#include "sudoku.h"
+
+/**
+ * Constraint propagation: computes the candidates of all 81 cells at once from the row,
+ * column and box masks and fills naked singles (cells with one candidate) and hidden
+ * singles (numbers with one possible cell in a row, column or box) until nothing changes.
+ * The candidate kernel uses AVX2 or SSE2 when the CPU has them and plain loops otherwise.
+ *
+ * Returns the number of cells filled, or -1 (board left unchanged) when the board turned out
+ * to have no solution.
+*/
+int propagateSingles(Sudoku &sudoku);
+
+// Kernel picked for this CPU: "avx2", "sse2" or "scalar"
+const char* getPropagateKernel();
+
+// Forces a kernel (for benchmarks), returns false when it's unknown or not supported by this CPU.
+// Not thread-safe, call it before any propagation runs
+bool setPropagateKernel(const char *name);
+
+#endif
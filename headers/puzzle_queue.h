@@ -0,0 +1,42 @@
+#ifndef PUZZLE_QUEUE_H
+#define PUZZLE_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "generator.h"
+#include "stats.h"
+
+/**
+ * Keeps a few finished puzzles ready for every level (Easy, Medium, Hard).
+ * A background thread refills the queues whenever one runs below capacity,
+ * so starting a game only has to take the next puzzle.
+*/
+class PuzzleQueue {
+private:
+    static const int LEVELS = 3;
+    std::deque <Puzzle> ready[LEVELS];
+    size_t capacity;
+    int wanted;         // Level a caller of take() is waiting for, -1 when nobody waits
+    bool stopping;
+    std::vector <Random> random;    // Seeds of the puzzles per level, only used by the worker thread
+    StatsReport *report;
+    long generated;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::thread worker;
+    int nextLevel();
+    void workerLoop();
+public:
+    // Puzzles follow from seed, report (may be NULL) gets the stats of every puzzle the worker generates
+    PuzzleQueue(int capacity, uint64_t seed, StatsReport *report);
+    ~PuzzleQueue();
+    // Returns a ready puzzle, waiting for the worker only when the queue of that level is empty
+    Puzzle take(int level);
+    // Takes a ready puzzle without waiting, returns false when none is ready
+    bool tryTake(int level, Puzzle &puzzle);
+};
+
+#endif
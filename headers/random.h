@@ -0,0 +1,40 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+/**
+ * xoshiro256** generator. Every generator owns its state, so threads never share one,
+ * and the same seed always gives the same sequence.
+*/
+class Random {
+private:
+    uint64_t state[4];
+    static uint64_t rotate(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+public:
+    Random(uint64_t seed);
+
+    uint64_t next() {
+        uint64_t result = rotate(this->state[1] * 5, 7) * 9;
+        uint64_t t = this->state[1] << 17;
+
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+        this->state[2] ^= t;
+        this->state[3] = rotate(this->state[3], 45);
+
+        return result;
+    }
+
+    // Uniform number in [0, limit), limit has to be positive
+    int below(int limit) {
+        return (int) (((this->next() >> 32) * (uint64_t) limit) >> 32);
+    }
+};
+
+// Seed that differs between runs and between calls, for when none was given
+uint64_t randomSeed();
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <ncurses.h>
+#include <cstdio>
+
+// Bytes written to the terminal (and anywhere else) by this process so far
+long getOutputBytes();
+
+// What the input event behind a frame did
+enum FramePath {
+    MENU_FRAME,         // Menus, prompts and keys that leave the board
+    NAVIGATION_FRAME,   // Moving the cursor over the board
+    ENTRY_FRAME,        // Entering a number, undo and redo
+    TICK_FRAME,         // Input timeout driving the reveal animation
+    FRAME_PATHS
+};
+
+/**
+ * Frame timing. beginFrame() is called when an input event arrives, finishFrame() when the
+ * program waits for the next one, and records how long the event took and how many bytes it
+ * sent to the terminal. endFrame() pushes every window prepared with wnoutrefresh() to the
+ * terminal with a single doupdate().
+*/
+struct RenderStats {
+    long frames;
+    long bytes;
+    double totalMs;
+    double maxMs;
+};
+
+// Frames aren't timed until this is called, timing reads /proc/self/io twice per frame.
+// With keepLatencies every frame's latency is kept for the percentiles of writeRenderStatsJson
+void enableFrameStats(bool keepLatencies);
+void beginFrame(FramePath path);
+void endFrame();
+void finishFrame();
+RenderStats getRenderStats(FramePath path);
+void printRenderStats(FILE *output);
+// Frames, bytes per frame and latency percentiles of every path as one JSON object (no newline)
+void writeRenderStatsJson(FILE *output);
+
+/**
+ * Draws a 9x9 board into its window and remembers what every cell shows, so a frame only
+ * redraws the cells that actually changed. Cells are addressed like the game does:
+ * x is the column on screen, y the line.
+*/
+class BoardView {
+public:
+    enum CellStyle {
+        BLANK,          // Empty field
+        CURSOR,         // Empty field under the cursor
+        NUMBER,         // Given or correctly filled number
+        SELECTED,       // Number under the cursor
+        WRONG,          // Number that doesn't match the solution
+        CONFLICT        // Number that occurs again in its row, column or box
+    };
+private:
+    struct Cell {
+        int number;
+        CellStyle style;
+    };
+
+    WINDOW *window;
+    Cell wanted[9][9];      // What the cells should show
+    Cell shown[9][9];       // What was drawn last, number -1 when never drawn
+    bool gridDrawn;
+    int revealed;           // Cells the reveal animation has uncovered, 81 when not animating
+    void drawCell(int x, int y);
+public:
+    BoardView(WINDOW *window);
+    void setCell(int x, int y, int number, CellStyle style);
+    // Forgets what was drawn, the next draw() repaints the whole board
+    void invalidate();
+    // Starts uncovering the numbers a few cells per tick instead of all at once
+    void startReveal();
+    bool isRevealing();
+    void tick();
+    // Draws the changed cells and marks the window for the next doupdate(), returns the cells drawn
+    int draw();
+};
+
+#endif
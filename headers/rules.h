@@ -0,0 +1,86 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Rules of a 9x9 board described as data: a list of units, groups of up to 9 cells that hold
+ * different numbers. Rows, columns and boxes are units like any other, so are the diagonals of
+ * X-Sudoku, the irregular regions of jigsaw sudoku and killer cages, which also add up to a sum.
+ * The classic game is the rows, columns and boxes.
+*/
+struct Unit {
+    uint8_t cells[9];   // row * 9 + col
+    int size;
+    int sum;            // Killer cages only, 0 when the numbers may add up to anything
+};
+
+class Rules {
+private:
+    std::vector <Unit> units;
+public:
+    void addUnit(const int *cells, int size, int sum = 0);
+    void addRows();
+    void addColumns();
+    void addBoxes();
+    // Both main diagonals (X-Sudoku)
+    void addDiagonals();
+    // 81 characters, cells with the same character form a region. Returns false unless there
+    // are 9 regions of 9 cells
+    bool addRegions(const char *map);
+    // 81 characters, cells with the same character form a cage and '.' is in none. sums holds
+    // the sum of every cage in the order their first cell comes row by row. Returns false when
+    // the map doesn't match the sums or a cage can't add up to its sum
+    bool addCages(const char *map, const std::vector <int> &sums);
+    const std::vector <Unit>& getUnits() const;
+};
+
+/**
+ * Parses a rule set (sudoku --rules SPEC), parts separated by '+':
+ *   classic                        rows, columns and boxes
+ *   x                              adds both diagonals
+ *   jigsaw:MAP                     regions (see addRegions) instead of boxes
+ *   killer:MAP:SUM,SUM,...         adds cages (see addCages)
+ * Rows and columns are always there. Returns false with a message in error when the spec is wrong.
+*/
+bool parseRules(const std::string &spec, Rules &rules, std::string &error);
+
+/**
+ * Lookup tables a rule set compiles into, built once and shared by every board using them.
+ * Every cell lists its units (cages apart, since they also restrict the sum) and its peers,
+ * the cells that can't hold the same number. Solving and generating only go through these
+ * tables, so any rule set runs the same code as the classic one.
+*/
+struct RuleTables {
+    static const int MAX_UNITS = 128;
+    static const int MAX_CELL_UNITS = 8;
+
+    int unitCount;
+    uint8_t unitCells[MAX_UNITS][9];
+    uint8_t unitSize[MAX_UNITS];
+    uint8_t unitSum[MAX_UNITS];                     // 0 for units without a sum
+    uint8_t cellUnits[81][MAX_CELL_UNITS];          // Units without a sum
+    uint8_t cellUnitCount[81];
+    uint8_t cellCages[81][MAX_CELL_UNITS];          // Units with a sum
+    uint8_t cellCageCount[81];
+    uint8_t peers[81][80];
+    uint8_t peerCount[81];
+
+    // Returns false with a message in error when a cell is in too many units
+    bool compile(const Rules &rules, std::string &error);
+};
+
+// Tables of the classic rules (rows, then columns, then boxes), compiled on first use
+const RuleTables& getClassicRules();
+
+/**
+ * Numbers (bit number - 1) that can go into an empty cell of a cage whose filled cells hold
+ * the numbers in used, with empty cells left and remaining still to add up to. A number is
+ * possible when it's part of some set of empty different unused numbers adding up to remaining.
+ * Looked up in a table of all 512 x 10 x 46 cases.
+*/
+uint16_t getCageCandidates(uint16_t used, int empty, int remaining);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstdint>
+#include <string>
+#include "solver.h"
+
+/**
+ * Puzzle service (sudoku --serve SOCKET).
+ * Listens on a Unix domain socket (replacing only a stale socket at the path) and answers one
+ * request per line, in the order they were sent on the connection (requests can be pipelined):
+ *
+ *   GEN <level>          OK <puzzle> <solution> <id>
+ *   SOLVE <puzzle>       OK <solution> | ERR invalid | ERR unsolvable | ERR budget | ERR cancelled
+ *   VALIDATE <puzzle>    OK unique | OK multiple | OK unsolvable | OK invalid | ERR budget | ERR cancelled
+ *
+ * Puzzles are 81 characters (0 or . for blank fields), the ID is 16 hex digits (see makePuzzleId).
+ * Malformed requests are answered with "ERR <reason>".
+ * An epoll loop does all socket IO, the requests read in one round are handed to a worker pool
+ * in batches. GEN is served from a cache kept full in the background and only generates on the
+ * worker when the cache of that level is empty. SOLVE and VALIDATE give up after the budget (see
+ * solveBounded) and when the server shuts down, a budget needs a solver that can stop early.
+ * Runs until SIGINT / SIGTERM, returns the exit code.
+*/
+int runServer(const std::string &socketPath, int threads, const std::string &solverName, uint64_t seed, const SearchBudget &budget);
+
+/**
+ * Load test client (sudoku --load-test SOCKET --count N).
+ * Sends N requests (GEN, SOLVE and VALIDATE taking turns) over several connections with a
+ * window of pipelined requests each, then prints throughput and latency percentiles as JSON.
+*/
+int runLoadTest(const std::string &socketPath, long count, int connections, int pipeline);
+
+#endif
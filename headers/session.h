@@ -0,0 +1,58 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <ncurses.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "generator.h"
+
+/**
+ * Keystroke sessions (sudoku --record FILE, sudoku --replay FILE).
+ *
+ * Every key the game reads goes through readKey(). While recording, readKey() logs it with the
+ * milliseconds since the previous key and every new game logs its puzzle, so the whole session
+ * can be played again. A replay feeds the logged keys back at full speed: the screen is a
+ * virtual terminal of the recorded size and type whose output is thrown away, and the frame
+ * stats of every input path (see finishFrame) are the benchmark.
+ *
+ * File layout: SessionHeader, then one event after the other, each a tag byte followed by
+ *   'k'  milliseconds since the previous key (LEB128), then the key (int16, ERR for an input timeout)
+ *   'p'  ID of a generated puzzle (uint64)
+ *   'b'  puzzle without an ID as an 81 byte bank entry (see encodeBankEntry)
+*/
+struct SessionHeader {
+    char magic[4];          // "SDKS"
+    uint32_t version;
+    uint16_t lines;         // Terminal size
+    uint16_t columns;
+    uint32_t flags;         // SESSION_ANIMATE
+    char term[32];          // $TERM of the recording, null terminated
+};
+
+static const uint32_t SESSION_ANIMATE = 1;
+
+// Returns false (and prints why to stderr) when the file can't be created
+bool startRecording(const std::string &path, int lines, int columns, bool animate);
+// Loads a whole recorded session, returns false (and prints why to stderr) when it isn't one
+bool startReplay(const std::string &path, SessionHeader &header);
+bool isReplaying();
+
+// Logs the puzzle of a new game, or takes it from the log when replaying
+void recordPuzzle(Puzzle &puzzle);
+Puzzle replayPuzzle();
+
+// Writes out what is left of a recording
+void finishSession();
+
+/**
+ * Reads the next key for a window. Refreshes the window first like wgetch() would, then closes
+ * the frame of the previous key and opens the frame of this one, board keys get their own frame
+ * paths when inGame is set. A replay that runs out of keys ends the program with its report.
+*/
+int readKey(WINDOW *window, bool inGame);
+
+// Keys, recorded and replayed time and the frame stats of a replay as one JSON line
+void writeReplayReport(FILE *output);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <atomic>
+#include <string>
+#include "sudoku.h"
+
+// How a bounded search ended
+enum SearchResult {
+    SEARCH_SOLVED,
+    SEARCH_UNSOLVABLE,      // Proved to have no solution
+    SEARCH_BUDGET,          // Gave up after the node or time budget
+    SEARCH_CANCELLED        // Gave up because the cancel token was triggered
+};
+
+// Lets any thread tell the searches watching it to give up
+class CancelToken {
+private:
+    std::atomic<bool> cancelled;
+public:
+    CancelToken() : cancelled(false) {}
+    void cancel() { this->cancelled.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return this->cancelled.load(std::memory_order_relaxed); }
+};
+
+// Limits of one search, 0 (or NULL) for no limit
+struct SearchBudget {
+    long nodes;
+    double ms;
+    const CancelToken *cancel;
+};
+
+// Common interface of the solving engines, so they can be swapped and benchmarked against each other
+class Solver {
+public:
+    virtual ~Solver() {}
+    virtual const char* getName() = 0;
+    // Fills every empty cell of the sudoku, returns false when the puzzle has no solution
+    virtual bool solve(Sudoku &sudoku) = 0;
+    // Like solve(), but may give up within the budget and leave the sudoku as it was.
+    // Only solvers where isBounded() holds can stop early, the others always search to the end
+    virtual SearchResult solveBounded(Sudoku &sudoku, const SearchBudget &budget);
+    // Counts the solutions up to limit, 2 is enough to tell unique puzzles from the others
+    virtual int countSolutions(Sudoku &sudoku, int limit);
+    // Like countSolutions(), but may give up within the budget. solutions is only complete with SEARCH_SOLVED
+    virtual SearchResult countBounded(Sudoku &sudoku, int limit, int &solutions, const SearchBudget &budget);
+    // True when solveBounded() and countBounded() honor the budget and the cancel token
+    virtual bool isBounded();
+};
+
+// Recursive backtracker built into the Sudoku class
+class BacktrackingSolver : public Solver {
+public:
+    const char* getName();
+    bool solve(Sudoku &sudoku);
+};
+
+// Returns a new solver for the given name ("backtracking", "dlx", "iterative" or "parallel") or NULL when the name is unknown
+Solver* createSolver(const std::string &name);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+/**
+ * Instrumentation of the solving and generating hot paths.
+ * Every thread counts into its own Counters, so counting is a plain increment.
+ * Building with -DSUDOKU_NO_STATS turns every STATS_ macro into nothing.
+*/
+struct Counters {
+    uint64_t nodes;             // Numbers tried by a search (rows tried by DLX)
+    uint64_t backtracks;        // Numbers taken back because they led nowhere
+    uint64_t maxDepth;          // Deepest recursion of a search
+    uint64_t isSafeCalls;
+    uint64_t propagated;        // Cells filled by constraint propagation
+    uint64_t gridAttempts;      // Full grids shuffled for a puzzle
+    uint64_t removalAttempts;   // Clues the generators tried to take away
+    uint64_t removals;          // Clues actually taken away
+    uint64_t grades;            // gradeSudoku calls
+};
+
+extern thread_local Counters threadCounters;
+
+#ifndef SUDOKU_NO_STATS
+#define STATS_ADD(field, amount) (threadCounters.field += (amount))
+#define STATS_MAX(field, value) do { \
+        if((uint64_t) (value) > threadCounters.field) threadCounters.field = (value); \
+    } while(0)
+#else
+#define STATS_ADD(field, amount) ((void) 0)
+#define STATS_MAX(field, value) ((void) 0)
+#endif
+
+// Returns the counters of the calling thread and starts them over
+Counters takeCounters();
+
+// Adds counters taken on another thread to those of the calling thread
+void mergeCounters(const Counters &counters);
+
+// One solved or generated puzzle
+struct PuzzleStats {
+    long index;         // Position in the input or output
+    uint64_t id;        // Puzzle ID when generated, 0 otherwise
+    double ms;
+    Counters counters;
+};
+
+/**
+ * Collects the stats of many puzzles (sudoku --stats / --stats-json FILE).
+ * Every puzzle is written as one JSON line when added, the summary keeps the totals,
+ * the latency percentiles and the slowest puzzle. Safe to use from several threads.
+*/
+class StatsReport {
+private:
+    std::mutex lock;
+    FILE *json;
+    std::vector <double> latencies;
+    Counters total;
+    PuzzleStats slowest;
+public:
+    // json can be NULL when only the summary is wanted
+    StatsReport(FILE *json);
+    void add(const PuzzleStats &puzzle);
+    void printSummary(FILE *output, const char *title);
+    // Writes the summary as the last JSON line
+    void writeSummaryJson(const char *title);
+};
+
+#endif
@@ -1,25 +1,68 @@
 #ifndef SUDOKU_H
 #define SUDOKU_H
 
-#include <vector>
+#include <stdint.h>
+#include <type_traits>
+#include "random.h"
 
-class Sudoku {
+template <int BoxN> class IterativeSearch;
+template <int BoxN> class ParallelSearch;
+
+/**
+ * Sudoku board with BoxN x BoxN boxes, so SIZE x SIZE cells holding numbers 1..SIZE.
+ * The box size is a compile-time constant: every loop bound and mask width is fixed per
+ * instance, 9x9 keeps 16-bit masks while 25x25 switches to 32-bit ones.
+ * Instantiated for BoxN 2 to 5 (4x4 up to 25x25).
+ * The board is a plain value: one byte per cell plus the masks, nothing on the heap, so
+ * copies are a memcpy (144 bytes for 9x9).
+*/
+template <int BoxN>
+class BasicSudoku {
+public:
+    static const int SIZE = BoxN * BoxN;
+    static const int CELLS = SIZE * SIZE;
+    typedef typename std::conditional<(SIZE > 16), uint32_t, uint16_t>::type Mask;
+    static const Mask ALL = (Mask) ((1u << SIZE) - 1);
 private:
-    int sudokuArr[9][9];
-    std::vector <int> numbers;
+    uint8_t sudokuArr[SIZE][SIZE];
+    // Bit (number - 1) is set when number is already used in the row / column / box
+    Mask rowMask[SIZE];
+    Mask colMask[SIZE];
+    Mask boxMask[SIZE];
+    long searchNodes;
+    static int boxIndex(int row, int col) { return (row / BoxN) * BoxN + col / BoxN; }
+    void clearBoard();
+    void placeNumber(int row, int col, int number);
+    void removeNumber(int row, int col);
+    void refreshMasks(int row, int col, int number);
+    int findConstrainedCell(int &row, int &col, Mask &candidates);
+    int findHiddenSingle(int &row, int &col, Mask &candidates);
+    bool solveConstrained(int depth);
+    void countConstrained(int &count, int limit, int depth);
+    // Searches with an explicit stack on top of the same cell choice and moves
+    friend class IterativeSearch<BoxN>;
+    // Splits the search tree at the cells the search would branch on
+    friend class ParallelSearch<BoxN>;
 public:
-    int getItem(int x, int y);
-    Sudoku();
-    ~Sudoku();
-    Sudoku(int grid[9][9]);
-    Sudoku* copySudoku();
-    void createSeed();
+    int getItem(int x, int y) const;
+    BasicSudoku();
+    BasicSudoku(int grid[SIZE][SIZE]);
     void printSudoku();
+    bool loadString(const char *text);
+    void writeString(char *text);
     bool isSafe(int row, int col, int number);
+    bool isValid();
     bool solveSudoku(int row, int col);
-    void generateSudoku(int level);
+    int countSolutions(int limit);
+    long getSearchNodes();
+    void generateSudoku(int level, Random &random, bool minimal = false);
     int countBlank();
     void setItem(int x, int y, int number);
 };
 
+// The classic 9x9 game
+typedef BasicSudoku<3> Sudoku;
+
+static_assert(std::is_trivially_copyable<Sudoku>::value, "Sudoku boards are copied with memcpy");
+
 #endif
\ No newline at end of file
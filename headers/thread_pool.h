@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool. Every worker owns a deque: tasks submitted by a worker go to
+ * the back of its own deque and are taken from there (newest first), idle workers steal
+ * from the front of the other deques. Tasks submitted from outside are spread round-robin.
+*/
+class ThreadPool {
+private:
+    struct WorkQueue {
+        std::deque <std::function<void()> > tasks;
+        std::mutex lock;
+    };
+
+    std::vector <std::thread> workers;
+    std::vector <WorkQueue*> queues;
+    std::mutex lock;                    // Only guards sleeping and waiting
+    std::condition_variable taskAdded;
+    std::condition_variable taskDone;
+    std::atomic<int> queued;            // Submitted tasks no worker has taken yet
+    std::atomic<int> pending;           // Submitted tasks not finished yet
+    std::atomic<unsigned> nextQueue;
+    bool stopping;
+    bool takeTask(int index, std::function<void()> &task);
+    void workerLoop(int index);
+public:
+    // threads <= 0 uses one worker per core
+    ThreadPool(int threads);
+    ~ThreadPool();
+    int getSize();
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task (including the ones submitted by tasks) has finished
+    void wait();
+    // Index of the calling worker of this pool, -1 when called from another thread
+    int getWorkerIndex();
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef VARIANT_H
+#define VARIANT_H
+
+#include <chrono>
+#include <cstdint>
+#include "random.h"
+#include "rules.h"
+#include "solver.h"
+
+/**
+ * 9x9 board played by any rule set (see RuleTables). Every unit keeps a mask of its numbers,
+ * and cages also their sum and empty cells, so the candidates of a cell are the OR of its few
+ * unit masks, narrowed by a table lookup per cage. With the classic rules that's the same work
+ * as Sudoku::isSafe.
+ * The board is a plain value pointing at the shared tables, which have to outlive it.
+*/
+class VariantSudoku {
+public:
+    typedef uint16_t Mask;
+    static const Mask ALL = 0x1FF;
+private:
+    const RuleTables *rules;
+    uint8_t cells[81];
+    Mask unitMask[RuleTables::MAX_UNITS];
+    uint8_t unitTotal[RuleTables::MAX_UNITS];   // Sum of the numbers in a cage so far
+    uint8_t unitEmpty[RuleTables::MAX_UNITS];   // Empty cells of a cage
+    long searchNodes;
+    SearchBudget budget;                        // Limits of the running search, random ones use the nodes too
+    std::chrono::steady_clock::time_point deadline;
+    SearchResult stopped;                       // Why the running search gave up, SEARCH_SOLVED until it does
+    Mask getCandidates(int cell);
+    void placeNumber(int cell, int number);
+    void removeNumber(int cell);
+    void refreshUnit(int unit);
+    bool isOutOfBudget();
+    int findConstrainedCell(int &cell, Mask &candidates);
+    int findHiddenSingle(const Mask fits[81], int &cell, Mask &candidates);
+    bool solveConstrained(int depth, Random *random);
+    void countConstrained(int &count, int limit, int depth);
+public:
+    VariantSudoku(const RuleTables &rules);
+    // Same format as Sudoku::loadString / writeString
+    bool loadString(const char *text);
+    void writeString(char *text);
+    int getItem(int row, int col) const;
+    void setItem(int row, int col, int number);
+    bool isSafe(int row, int col, int number);
+    // True when no number repeats within a unit and no cage is past its sum (or full and short of it)
+    bool isValid();
+    bool solve();
+    // Like solve(), but gives up within the budget (see IterativeSearch) and leaves the board as it was
+    SearchResult solveBounded(const SearchBudget &budget);
+    // Fills the board with a random solution, false when there's none (or none turned up within
+    // some 30 million nodes, which only happens with rules that don't fit together)
+    bool solveRandom(Random &random);
+    int countSolutions(int limit);
+    long getSearchNodes();
+    int countBlank();
+    const RuleTables& getRules() const;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <string>
+
+/**
+ * Bulk verification of completed grids (sudoku --verify FILE).
+ * Every line of path ("-" for stdin) holds an 81 character solution, or a puzzle and its solution
+ * separated by a space, tab, comma or semicolon (anything after the solution is ignored). A board
+ * passes when every row, column and box holds 1 to 9 once and the solution keeps every given of
+ * the puzzle.
+ * Boards are transposed in blocks of 32 into a structure of arrays, one byte lane per board, so
+ * a single AVX2 instruction checks the same cell of 32 boards. Numbers become bits with a byte
+ * shuffle (pshufb) and a unit is complete when its OR has all 9 bits. Boards that fail are checked
+ * again one by one to report what is wrong, as "line N: ..." on stdout.
+ * Returns the process exit code, 1 when a board failed.
+*/
+int runVerify(const std::string &path);
+
+// Kernel picked for this CPU: "avx2", "ssse3" or "scalar"
+const char* getVerifyKernel();
+
+// Forces a kernel (for benchmarks), returns false when it's unknown or not supported by this CPU.
+// Not thread-safe, call it before any verification runs
+bool setVerifyKernel(const char *name);
+
+#endif
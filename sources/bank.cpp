@@ -0,0 +1,262 @@
+#include "../headers/bank.h"
+#include "../headers/thread_pool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t BANK_VERSION = 1;
+static const uint32_t ENTRY_SIZE = 81;
+static const int LEVELS = 3;
+static const int TASK_PUZZLES = 16;
+static const int RANDOM_PICKS = 8;      // Damaged entries picked in a row before getRandomPuzzle gives up
+
+PuzzleBank::PuzzleBank() : random(randomSeed()) {
+    this->data = NULL;
+    this->size = 0;
+    this->header = NULL;
+}
+
+PuzzleBank::~PuzzleBank() {
+    if(this->data != NULL) {
+        munmap((void*) this->data, this->size);
+    }
+}
+
+bool PuzzleBank::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        fprintf(stderr, "Can't open %s\n", path.c_str());
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(BankHeader)) {
+        fprintf(stderr, "%s is not a puzzle bank\n", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) {
+        fprintf(stderr, "Can't map %s\n", path.c_str());
+        return false;
+    }
+
+    this->data = (const unsigned char*) mapping;
+    this->size = info.st_size;
+    this->header = (const BankHeader*) mapping;
+
+    bool valid = memcmp(this->header->magic, "SDKB", 4) == 0
+        && this->header->version == BANK_VERSION
+        && this->header->entrySize == ENTRY_SIZE
+        && this->header->levels == LEVELS;
+
+    // Written as a division, a crafted count can't wrap the end of the level past the check
+    for(int level = 0; level < LEVELS && valid; level++) {
+        uint64_t offset = this->header->offset[level];
+        if(offset < sizeof(BankHeader) || offset > this->size || this->header->count[level] > (this->size - offset) / ENTRY_SIZE) valid = false;
+    }
+
+    // Only the header is checked here, whatever the size of the bank. An entry is checked when it's
+    // picked (see getPuzzle), which touches its page anyway
+
+    // Entries are picked at random, read-ahead would only waste page cache
+    madvise(mapping, info.st_size, MADV_RANDOM);
+
+    if(!valid) {
+        fprintf(stderr, "%s is not a valid puzzle bank\n", path.c_str());
+        munmap(mapping, this->size);
+        this->data = NULL;
+        this->header = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+long PuzzleBank::getCount(int level) {
+    if(this->header == NULL || level < 0 || level >= LEVELS) return 0;
+    return this->header->count[level];
+}
+
+const unsigned char* PuzzleBank::getEntry(int level, long index) {
+    return this->data + this->header->offset[level] + (uint64_t) index * ENTRY_SIZE;
+}
+
+bool PuzzleBank::getPuzzle(int level, long index, Puzzle &puzzle) {
+    const unsigned char *entry = this->getEntry(level, index);
+    if(!isValidBankEntry(entry)) return false;
+
+    puzzle = decodeBankEntry(entry);
+    return true;
+}
+
+long PuzzleBank::getRandomIndex(int level) {
+    return this->random.next() % this->getCount(level);
+}
+
+bool PuzzleBank::getRandomPuzzle(int level, Puzzle &puzzle) {
+    for(int attempt = 0; attempt < RANDOM_PICKS; attempt++) {
+        if(this->getPuzzle(level, this->getRandomIndex(level), puzzle)) return true;
+    }
+    return false;
+}
+
+void encodeBankEntry(Puzzle &puzzle, unsigned char *entry) {
+    for(int i = 0; i < 81; i++) {
+        entry[i] = (puzzle.puzzle.getItem(i / 9, i % 9) << 4) | puzzle.solution.getItem(i / 9, i % 9);
+    }
+}
+
+bool isValidBankEntry(const unsigned char *entry) {
+    uint16_t rows[9] = {0}, cols[9] = {0}, boxes[9] = {0};
+
+    for(int i = 0; i < 81; i++) {
+        int given = entry[i] >> 4;
+        int number = entry[i] & 0x0F;
+        if(number < 1 || number > 9 || (given != 0 && given != number)) return false;
+
+        uint16_t bit = 1 << (number - 1);
+        rows[i / 9] |= bit;
+        cols[i % 9] |= bit;
+        boxes[(i / 27) * 3 + (i % 9) / 3] |= bit;
+    }
+
+    // 81 numbers cover every row, column and box only when none of them repeats
+    for(int k = 0; k < 9; k++) {
+        if(rows[k] != 0x1FF || cols[k] != 0x1FF || boxes[k] != 0x1FF) return false;
+    }
+    return true;
+}
+
+Puzzle decodeBankEntry(const unsigned char *entry) {
+    int solution[9][9];
+    int puzzle[9][9];
+
+    for(int i = 0; i < 81; i++) {
+        puzzle[i / 9][i % 9] = entry[i] >> 4;
+        solution[i / 9][i % 9] = entry[i] & 0x0F;
+    }
+
+    return Puzzle(0, Sudoku(solution), Sudoku(puzzle));
+}
+
+/**
+ * --------------------------- BANK TOOLS ---------------------------
+*/
+
+struct BankWriter {
+    FILE *file;
+    std::mutex lock;
+    bool failed;        // Some write came up short
+    int level;
+    long count;
+    long written;
+    uint64_t seed;
+    ThreadPool *pool;
+};
+
+static void generateEntries(BankWriter *writer, long first, int puzzles) {
+    std::vector <unsigned char> entries(puzzles * ENTRY_SIZE);
+
+    for(int i = 0; i < puzzles; i++) {
+        Puzzle puzzle = generatePuzzle(writer->level, writer->seed + first + i);
+        encodeBankEntry(puzzle, &entries[i * ENTRY_SIZE]);
+    }
+
+    std::unique_lock<std::mutex> guard(writer->lock);
+    if(fwrite(&entries[0], 1, entries.size(), writer->file) != entries.size()) writer->failed = true;
+    writer->written += puzzles;
+}
+
+int runBuildBank(const std::string &path, long count, int threads, uint64_t seed) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if(file == NULL) {
+        fprintf(stderr, "Can't create %s\n", path.c_str());
+        return 1;
+    }
+
+    BankHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "SDKB", 4);
+    header.version = BANK_VERSION;
+    header.entrySize = ENTRY_SIZE;
+    header.levels = LEVELS;
+
+    ThreadPool pool(threads);
+    BankWriter writer;
+    writer.file = file;
+    writer.failed = fwrite(&header, sizeof(header), 1, file) != 1;
+    writer.seed = seed;
+    writer.pool = &pool;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Levels are written one after another, so every level is one contiguous block
+    for(int level = 0; level < LEVELS; level++) {
+        header.offset[level] = ftell(file);
+        writer.level = level;
+        writer.written = 0;
+
+        for(long i = 0; i < count; i += TASK_PUZZLES) {
+            int puzzles = count - i < TASK_PUZZLES ? count - i : TASK_PUZZLES;
+            pool.submit(std::bind(generateEntries, &writer, i, puzzles));
+        }
+        pool.wait();
+
+        header.count[level] = writer.written;
+    }
+
+    // A bank cut short by a full disk would still pass for a valid one, so it's removed
+    // (unless it isn't a regular file, like a device)
+    if(fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1) writer.failed = true;
+    if(fclose(file) != 0) writer.failed = true;
+    if(writer.failed) {
+        fprintf(stderr, "Can't write %s\n", path.c_str());
+        struct stat info;
+        if(stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) remove(path.c_str());
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "Wrote %ld puzzles per level to %s in %.3f s\n", count, path.c_str(), seconds);
+    return 0;
+}
+
+int runBankSample(const std::string &path, int level, long count) {
+    PuzzleBank bank;
+    if(!bank.open(path)) return 1;
+
+    if(bank.getCount(level) == 0) {
+        fprintf(stderr, "The bank has no puzzles of level %d\n", level);
+        return 1;
+    }
+
+    setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+
+    char line[82];
+    line[81] = '\n';
+    for(long i = 0; i < count; i++) {
+        long index = bank.getRandomIndex(level);
+        const unsigned char *entry = bank.getEntry(level, index);
+        if(!isValidBankEntry(entry)) {
+            fflush(stdout);
+            fprintf(stderr, "%s has a damaged entry (level %d, #%ld)\n", path.c_str(), level, index);
+            return 1;
+        }
+
+        for(int cell = 0; cell < 81; cell++) {
+            line[cell] = '0' + (entry[cell] >> 4);
+        }
+        fwrite(line, 1, 82, stdout);
+    }
+
+    return 0;
+}
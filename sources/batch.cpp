@@ -0,0 +1,167 @@
+#include "../headers/batch.h"
+#include "../headers/line_pipeline.h"
+#include "../headers/parallel.h"
+#include "../headers/variant.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+struct BatchChunk : LineChunk {
+    std::string output;
+    long puzzles;
+    long solved;
+    bool measure;                       // Whether stats are kept for every puzzle
+    SearchBudget budget;
+    const RuleTables *rules;            // NULL for the classic rules
+    std::vector <PuzzleStats> stats;    // Indices relative to the chunk
+};
+
+// Answer line of a search that didn't solve the puzzle
+static const char* getFailure(SearchResult result) {
+    if(result == SEARCH_BUDGET) return "budget\n";
+    if(result == SEARCH_CANCELLED) return "cancelled\n";
+    return "unsolvable\n";
+}
+
+// Other sizes than 9x9 are solved with the iterative search (split over the search pool with the
+// parallel solver), the solvers only handle 9x9
+template <int BoxN>
+static bool solveOtherSize(const char *text, bool parallel, const SearchBudget &budget, std::string &output) {
+    int grid[BasicSudoku<BoxN>::SIZE][BasicSudoku<BoxN>::SIZE] = {{0}};
+    BasicSudoku<BoxN> sudoku(grid);
+    char line[BasicSudoku<BoxN>::CELLS + 1];
+    line[BasicSudoku<BoxN>::CELLS] = '\n';
+
+    if(!sudoku.loadString(text)) {
+        output.append("invalid\n");
+        return false;
+    }
+    SearchResult result;
+    if(parallel) {
+        result = ParallelSearch<BoxN>(getSearchPool()).solve(sudoku, budget);
+    } else {
+        result = IterativeSearch<BoxN>().solve(sudoku, budget);
+    }
+    if(result != SEARCH_SOLVED) {
+        output.append(getFailure(result));
+        return false;
+    }
+
+    sudoku.writeString(line);
+    output.append(line, BasicSudoku<BoxN>::CELLS + 1);
+    return true;
+}
+
+static void solveChunk(LineChunk *base, const std::string &solverName) {
+    BatchChunk *chunk = static_cast<BatchChunk*>(base);
+    Solver *solver = createSolver(solverName);
+    bool parallel = solverName == "parallel";
+    int grid[9][9] = {{0}};
+    Sudoku sudoku(grid);
+    char line[82];
+    line[81] = '\n';
+
+    chunk->puzzles = 0;
+    chunk->solved = 0;
+    chunk->output.reserve(chunk->input.size());
+
+    const std::string &input = chunk->input;
+    forEachLine(input, [&](size_t position, size_t length) {
+        std::chrono::steady_clock::time_point start;
+        if(chunk->measure) {
+            takeCounters();
+            start = std::chrono::steady_clock::now();
+        }
+
+        chunk->puzzles++;
+
+        if(chunk->rules != NULL) {
+            VariantSudoku variant(*chunk->rules);
+            SearchResult result = SEARCH_UNSOLVABLE;
+            if(length != 81 || !variant.loadString(&input[position])) {
+                chunk->output.append("invalid\n");
+            } else if((result = variant.solveBounded(chunk->budget)) == SEARCH_SOLVED) {
+                variant.writeString(line);
+                chunk->output.append(line, 82);
+                chunk->solved++;
+            } else {
+                chunk->output.append(getFailure(result));
+            }
+        } else if(length == 16) {
+            chunk->solved += solveOtherSize<2>(&input[position], parallel, chunk->budget, chunk->output);
+        } else if(length == 256) {
+            chunk->solved += solveOtherSize<4>(&input[position], parallel, chunk->budget, chunk->output);
+        } else if(length == 625) {
+            chunk->solved += solveOtherSize<5>(&input[position], parallel, chunk->budget, chunk->output);
+        } else if(length != 81 || !sudoku.loadString(&input[position])) {
+            chunk->output.append("invalid\n");
+        } else {
+            SearchResult result = solver->solveBounded(sudoku, chunk->budget);
+            if(result == SEARCH_SOLVED) {
+                sudoku.writeString(line);
+                chunk->output.append(line, 82);
+                chunk->solved++;
+            } else {
+                chunk->output.append(getFailure(result));
+            }
+        }
+
+        if(chunk->measure) {
+            PuzzleStats stats;
+            stats.index = chunk->puzzles - 1;
+            stats.id = 0;
+            stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats.counters = takeCounters();
+            chunk->stats.push_back(stats);
+        }
+    });
+
+    delete solver;
+}
+
+int runBatchSolve(const std::string &path, const std::string &solverName, int threads, const SearchBudget &budget, StatsReport *report, const RuleTables *rules) {
+    Solver *check = createSolver(solverName);
+    if(check == NULL) {
+        fprintf(stderr, "Unknown solver: %s\n", solverName.c_str());
+        return 1;
+    }
+    bool bounded = check->isBounded();
+    delete check;
+
+    // A budget nothing would honor is an error rather than silently searching to the end
+    if((budget.nodes > 0 || budget.ms > 0) && rules == NULL && !bounded) {
+        fprintf(stderr, "--budget-nodes and --budget-ms need --solver iterative or parallel\n");
+        return 1;
+    }
+
+    long puzzles = 0;
+    long solved = 0;
+
+    auto createChunk = [&]() -> LineChunk* {
+        BatchChunk *chunk = new BatchChunk();
+        chunk->measure = report != NULL;
+        chunk->budget = budget;
+        chunk->rules = rules;
+        return chunk;
+    };
+
+    // Writes out the chunks in input order
+    auto writeChunk = [&](LineChunk *base) {
+        BatchChunk *chunk = static_cast<BatchChunk*>(base);
+        fwrite(chunk->output.data(), 1, chunk->output.size(), stdout);
+        for(size_t i = 0; i < chunk->stats.size(); i++) {
+            chunk->stats[i].index += puzzles;
+            report->add(chunk->stats[i]);
+        }
+        puzzles += chunk->puzzles;
+        solved += chunk->solved;
+    };
+
+    LineRun run;
+    if(!runLinePipeline(path, threads, createChunk, std::bind(solveChunk, std::placeholders::_1, solverName), writeChunk, run)) return 1;
+
+    fprintf(stderr, "Solved %ld of %ld puzzles in %.3f s (%.0f puzzles/s, %d threads, %s)\n",
+        solved, puzzles, run.seconds, run.getRate(puzzles), run.threads, rules != NULL ? "rules" : solverName.c_str());
+
+    return 0;
+}
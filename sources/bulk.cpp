@@ -0,0 +1,151 @@
+#include "../headers/bulk.h"
+#include "../headers/generator.h"
+#include "../headers/hash_set.h"
+#include "../headers/thread_pool.h"
+#include "../headers/variant.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+
+static const int TASK_PUZZLES = 16;     // Puzzles generated by one task before it reschedules itself
+
+// FNV-1a over the 81 cells
+static uint64_t hashPuzzle(const char *text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for(int i = 0; i < 81; i++) {
+        hash ^= (unsigned char) text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+struct BulkJob {
+    long count;
+    int level;
+    uint64_t seed;
+    ShardedHashSet seen;                // Hashes of the puzzles so far
+    std::atomic<long> produced;
+    std::atomic<long> duplicates;
+    std::atomic<bool> failed;           // The rules gave no full grid or no puzzle of the level
+    std::atomic<long> nextIndex;        // Puzzle i is generated from seed + i
+    std::mutex output;
+    ThreadPool *pool;
+    StatsReport *report;                // NULL when no stats are kept
+    const RuleTables *rules;            // NULL for the classic rules
+};
+
+// Claims the next puzzle index. Only count + duplicates indices are ever handed out, so the
+// output is always the unique puzzles of the first indices, no matter which worker finishes first.
+// Returns -1 when every needed index is taken
+static long claimIndex(BulkJob *job) {
+    long index = job->nextIndex;
+    do {
+        if(index >= job->count + job->duplicates) return -1;
+    } while(!job->nextIndex.compare_exchange_weak(index, index + 1));
+
+    return index;
+}
+
+static void generateTask(BulkJob *job) {
+    if(job->produced >= job->count || job->failed) return;
+
+    std::string lines;
+    char line[82];
+    line[81] = '\n';
+
+    for(int i = 0; i < TASK_PUZZLES && job->produced < job->count; i++) {
+        long index = claimIndex(job);
+        if(index < 0) break;
+
+        std::chrono::steady_clock::time_point start;
+        if(job->report != NULL) {
+            takeCounters();
+            start = std::chrono::steady_clock::now();
+        }
+
+        uint64_t id = 0;
+        if(job->rules != NULL) {
+            VariantSudoku puzzle(*job->rules), solution(*job->rules);
+            if(!generateVariantPuzzle(*job->rules, job->level, job->seed + index, puzzle, solution)) {
+                job->failed = true;
+                break;
+            }
+            puzzle.writeString(line);
+        } else {
+            Puzzle puzzle = generatePuzzle(job->level, job->seed + index);
+            id = puzzle.id;
+            puzzle.puzzle.writeString(line);
+        }
+
+        if(job->report != NULL) {
+            PuzzleStats stats;
+            stats.index = index;
+            stats.id = id;
+            stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats.counters = takeCounters();
+            job->report->add(stats);
+        }
+
+        if(!job->seen.insert(hashPuzzle(line))) {
+            job->duplicates++;
+            continue;
+        }
+        if(job->produced.fetch_add(1) >= job->count) break;
+
+        lines.append(line, 82);
+    }
+
+    if(!lines.empty()) {
+        std::unique_lock<std::mutex> guard(job->output);
+        fwrite(lines.data(), 1, lines.size(), stdout);
+    }
+
+    // Keeps this worker busy, idle workers steal the tasks that pile up
+    if(job->produced < job->count && !job->failed) {
+        job->pool->submit(std::bind(generateTask, job));
+    }
+}
+
+int runBulkGenerate(long count, int level, int threads, uint64_t seed, StatsReport *report, const RuleTables *rules) {
+    if(level < 0 || level > 2) {
+        fprintf(stderr, "Level has to be 0 (Easy), 1 (Medium) or 2 (Hard)\n");
+        return 1;
+    }
+
+    setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+
+    ThreadPool pool(threads);
+    BulkJob job;
+    job.count = count;
+    job.level = level;
+    job.seed = seed;
+    job.produced = 0;
+    job.duplicates = 0;
+    job.failed = false;
+    job.nextIndex = 0;
+    job.pool = &pool;
+    job.report = report;
+    job.rules = rules;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < pool.getSize(); i++) {
+        pool.submit(std::bind(generateTask, &job));
+    }
+    pool.wait();
+    fflush(stdout);
+
+    if(job.failed) {
+        fprintf(stderr, "No full grid fits the rules, or none makes a puzzle of level %d\n", job.level);
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long generated = job.produced < count ? (long) job.produced : count;
+    fprintf(stderr, "Generated %ld unique puzzles (%ld duplicates dropped) in %.3f s (%.0f puzzles/s, %d threads)\n",
+        generated, (long) job.duplicates, seconds, seconds > 0 ? generated / seconds : 0.0, pool.getSize());
+
+    return 0;
+}
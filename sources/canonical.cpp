@@ -0,0 +1,822 @@
+#include "../headers/canonical.h"
+#include <algorithm>
+#include <cstring>
+
+static const uint8_t ORDERS_OF_3[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+
+// Numbers held by the three columns of a stack, in the given order, as a 3-bit pattern
+static int countNumbers(const uint8_t *row, int stack) {
+    return (row[stack * 3] != 0) + (row[stack * 3 + 1] != 0) + (row[stack * 3 + 2] != 0);
+}
+
+/**
+ * Where a row holds numbers once its columns are reordered, bit 8 - j stands for output column j.
+ * Numbers always get relabeled to 1, 2, 3... in the first row, so the first row with the smallest
+ * pattern is the smallest first row. The smallest pattern any column order gives a row has the
+ * numbers last in every stack and the stacks with fewer numbers first.
+*/
+static int bestRowPattern(const uint8_t *row) {
+    int counts[3] = {countNumbers(row, 0), countNumbers(row, 1), countNumbers(row, 2)};
+    std::sort(counts, counts + 3);
+    return (((1 << counts[0]) - 1) << 6) | (((1 << counts[1]) - 1) << 3) | ((1 << counts[2]) - 1);
+}
+
+static const uint16_t STACK_MASKS[3] = {0x007, 0x038, 0x1C0};   // Columns (or slots) of every stack
+static const int MAX_PENDING = 64;
+
+/**
+ * What a branch of the search has chosen so far. Output columns (slots) only get a source column
+ * once some cell needs a number there. The first row comes out the same for every column order
+ * giving it the smallest pattern, its numbers are labeled by slot, and a slot that only ever got
+ * blanks so far can take any blank column left, so neither needs to be chosen up front.
+*/
+struct Binding {
+    bool transpose;
+    int8_t cols[9];         // Source column of every slot, -1 while open
+    int8_t stacks[3];       // Source stack of every output stack, -1 while open
+    int8_t stackSlots[3];   // Output stack of every source stack, -1 while open
+    uint8_t labels[10];     // 0 for numbers without a label yet
+    uint8_t lastDigit;
+    uint8_t rows[9];
+    uint16_t openCols;      // Source columns without a slot
+    uint16_t openSlots;
+    uint16_t rowsUsed;
+    uint8_t bandsUsed;
+};
+
+/**
+ * Branch and bound over the cells of the result in reading order. A row is picked whenever a new
+ * row starts and a source stack whenever a cell lands in an open output stack. A cell in an open
+ * slot is 0 while its stack still has more columns blank in that row than open slots before it
+ * that were 0 too, otherwise a number column gets the slot. Every cell is compared with best, the
+ * smallest board found so far, and a larger cell ends the branch, so the first band is pruned
+ * cell by cell like every other row. The first band is searched for every first row before any
+ * of the rest, which then only starts from the bindings that gave the smallest one.
+ * A number of the first row whose column is still open takes the first slot it can, any later
+ * one would only make the cell larger. Rows, bands, stacks and columns identical to one tried
+ * before are skipped, swapping them doesn't change the board.
+*/
+struct CanonicalSearch {
+    uint8_t grids[2][9][9];     // The board and its transposition
+    uint16_t blankCols[2][9];   // Blank columns of every row
+    uint16_t sameRows[2][9];    // Identical rows of the same band
+    uint16_t sameBandRows[2][9];// Rows at the same place of an identical band
+    uint8_t sameStacks[2][3];   // Identical stacks
+    uint16_t sameCols[2][9];    // Identical columns of the same stack
+
+    bool transpose;
+    const uint8_t *first;       // First row
+    int8_t firstCols[10];       // Column of every number in the first row, -1 when it isn't there
+    uint16_t numberCols;        // Columns holding a number in the first row
+    uint16_t numberSlots;       // Slots holding one, the last ones of every output stack
+    uint8_t slotLabels[9];      // Their labels
+    uint8_t stackSizes[3];      // Numbers of the first row in every source stack
+    uint8_t slotStackSizes[3];  // And in every output stack, fewer first
+
+    uint8_t best[81];
+    Binding pending[9][MAX_PENDING];    // Bindings whose rows so far equal best, by depth
+    int pendingCount[9];
+    Transform found;
+
+    void run();
+    void compare();
+    void prepare(bool transpose, int row);
+    void start(int row);
+    void bindStack(Binding &binding, int stack, int slotStack) const;
+    void bindColumn(Binding &binding, int col, int slot) const;
+    int getLabel(Binding &binding, int number, int row, int slot) const;
+    void searchRow(int depth, const Binding &binding);
+    void tryRows(int depth, const Binding &binding);
+    void endRow(int depth, const Binding &binding);
+    void descend(int depth);
+    void searchCell(int cell, Binding &binding);
+    bool keepCell(int cell, int label);
+    void nextCell(int cell, Binding &binding);
+    void finish(Binding &binding);
+};
+
+// Finds the rows and bands of both orientations that are the same as others. The columns and
+// stacks of one orientation are the rows and bands of the other
+void CanonicalSearch::compare() {
+    uint8_t sameBands[2][3];
+
+    for(int t = 0; t < 2; t++) {
+        const uint8_t (*grid)[9] = this->grids[t];
+
+        for(int row = 0; row < 9; row++) {
+            this->blankCols[t][row] = 0;
+            this->sameRows[t][row] = this->sameBandRows[t][row] = 0;
+            for(int col = 0; col < 9; col++) {
+                if(grid[row][col] == 0) this->blankCols[t][row] |= 1 << col;
+            }
+        }
+
+        // Only rows blank in the same columns can be the same
+        for(int row = 0; row < 9; row++) {
+            for(int other = row / 3 * 3; other < row / 3 * 3 + 3; other++) {
+                if(other == row || this->blankCols[t][row] != this->blankCols[t][other]) continue;
+                if(memcmp(grid[row], grid[other], 9) == 0) this->sameRows[t][row] |= 1 << other;
+            }
+        }
+
+        for(int band = 0; band < 3; band++) {
+            sameBands[t][band] = 0;
+            for(int other = 0; other < 3; other++) {
+                if(other == band || memcmp(this->blankCols[t] + band * 3, this->blankCols[t] + other * 3, 6) != 0) continue;
+                if(memcmp(grid[band * 3], grid[other * 3], 27) != 0) continue;
+                sameBands[t][band] |= 1 << other;
+                for(int i = 0; i < 3; i++) this->sameBandRows[t][band * 3 + i] |= 1 << (other * 3 + i);
+            }
+        }
+    }
+
+    for(int t = 0; t < 2; t++) {
+        memcpy(this->sameCols[t], this->sameRows[1 - t], sizeof(this->sameCols[t]));
+        memcpy(this->sameStacks[t], sameBands[1 - t], sizeof(this->sameStacks[t]));
+    }
+}
+
+// Everything that only depends on the orientation and the first row
+void CanonicalSearch::prepare(bool transpose, int row) {
+    const uint8_t *first = this->grids[transpose][row];
+
+    this->transpose = transpose;
+    this->first = first;
+    this->numberCols = 0;
+    for(int number = 0; number <= 9; number++) this->firstCols[number] = -1;
+    for(int col = 0; col < 9; col++) {
+        if(first[col] == 0) continue;
+        this->firstCols[first[col]] = col;
+        this->numberCols |= 1 << col;
+    }
+
+    for(int stack = 0; stack < 3; stack++) {
+        this->stackSizes[stack] = this->slotStackSizes[stack] = countNumbers(first, stack);
+    }
+    std::sort(this->slotStackSizes, this->slotStackSizes + 3);
+
+    int lastDigit = 0;
+    this->numberSlots = 0;
+    for(int slot = 0; slot < 9; slot++) {
+        bool number = slot % 3 >= 3 - this->slotStackSizes[slot / 3];
+        if(number) this->numberSlots |= 1 << slot;
+        this->slotLabels[slot] = number ? ++lastDigit : 0;
+    }
+}
+
+// Tries every second row after the given first row
+void CanonicalSearch::start(int row) {
+    Binding binding;
+    this->prepare(this->transpose, row);
+
+    // The first row is the same for every first row with the smallest pattern
+    memcpy(this->best, this->slotLabels, 9);
+
+    binding.transpose = this->transpose;
+    memset(binding.cols, -1, sizeof(binding.cols));
+    memset(binding.stacks, -1, sizeof(binding.stacks));
+    memset(binding.stackSlots, -1, sizeof(binding.stackSlots));
+    memset(binding.labels, 0, sizeof(binding.labels));
+    binding.lastDigit = __builtin_popcount(this->numberSlots);
+    binding.rows[0] = row;
+    binding.openCols = binding.openSlots = 0x1FF;
+    binding.rowsUsed = 1 << row;
+    binding.bandsUsed = 1 << (row / 3);
+
+    this->tryRows(1, binding);
+}
+
+void CanonicalSearch::bindStack(Binding &binding, int stack, int slotStack) const {
+    binding.stacks[slotStack] = stack;
+    binding.stackSlots[stack] = slotStack;
+}
+
+void CanonicalSearch::bindColumn(Binding &binding, int col, int slot) const {
+    binding.cols[slot] = col;
+    binding.openCols &= ~(1 << col);
+    binding.openSlots &= ~(1 << slot);
+    if(this->numberSlots & (1 << slot)) binding.labels[this->first[col]] = this->slotLabels[slot];
+}
+
+// Label of a number in the given row, on its way into slot. Numbers of the first row still
+// without a slot take the first one they fit, new numbers the next label
+int CanonicalSearch::getLabel(Binding &binding, int number, int row, int slot) const {
+    if(number == 0 || binding.labels[number] != 0) return binding.labels[number];
+
+    int col = this->firstCols[number];
+    if(col < 0) return binding.labels[number] = ++binding.lastDigit;
+
+    int stack = col / 3;
+    if(binding.stackSlots[stack] < 0) {
+        for(int slotStack = 0; slotStack < 3; slotStack++) {
+            if(binding.stacks[slotStack] < 0 && this->slotStackSizes[slotStack] == this->stackSizes[stack]) {
+                this->bindStack(binding, stack, slotStack);
+                break;
+            }
+        }
+    }
+
+    uint16_t free = binding.openSlots & this->numberSlots & STACK_MASKS[binding.stackSlots[stack]];
+    // The open slots before this one were 0 in this row, only a column blank there can go back
+    if(!(this->blankCols[this->transpose][row] & (1 << col))) free &= ~((1 << slot) - 1);
+    // Only boards repeating a number get here without a slot
+    if(free == 0) return binding.labels[number] = ++binding.lastDigit;
+
+    this->bindColumn(binding, col, __builtin_ctz(free));
+    return binding.labels[number];
+}
+
+// Tries every row at depth, then goes on from every binding that gave the smallest one
+void CanonicalSearch::searchRow(int depth, const Binding &binding) {
+    this->pendingCount[depth] = 0;
+    this->tryRows(depth, binding);
+    this->descend(depth);
+}
+
+void CanonicalSearch::tryRows(int depth, const Binding &binding) {
+    int from = 0, to = 9;
+    if(depth % 3 != 0) {
+        // Rest of the band of the previous row
+        from = binding.rows[depth - 1] / 3 * 3;
+        to = from + 3;
+    }
+
+    uint16_t tried = 0;
+    for(int row = from; row < to; row++) {
+        if(binding.rowsUsed & (1 << row)) continue;
+        // A band starts with any row of a band not used yet
+        if(depth % 3 == 0 && binding.bandsUsed & (1 << (row / 3))) continue;
+
+        uint16_t same = this->sameRows[this->transpose][row];
+        if(depth % 3 == 0) same |= this->sameBandRows[this->transpose][row];
+        if(same & tried) continue;
+        tried |= 1 << row;
+
+        Binding next = binding;
+        next.rows[depth] = row;
+        next.rowsUsed |= 1 << row;
+        next.bandsUsed |= 1 << (row / 3);
+        this->searchCell(depth * 9, next);
+    }
+}
+
+// A row came out no larger than best. It waits for the other rows at its depth unless there are
+// too many ties, rows found smaller later on drop it (see keepCell)
+void CanonicalSearch::endRow(int depth, const Binding &binding) {
+    if(depth == 8) {
+        Binding last = binding;
+        this->finish(last);
+    } else if(this->pendingCount[depth] < MAX_PENDING) {
+        this->pending[depth][this->pendingCount[depth]++] = binding;
+    } else {
+        this->searchRow(depth + 1, binding);
+    }
+}
+
+void CanonicalSearch::descend(int depth) {
+    for(int i = 0; i < this->pendingCount[depth]; i++) {
+        const Binding &binding = this->pending[depth][i];
+        // Second rows of every first row wait together
+        if(depth == 1) this->prepare(binding.transpose, binding.rows[0]);
+        this->searchRow(depth + 1, binding);
+    }
+}
+
+// Goes through the rest of the row from cell, cells in bound slots in place, others by branching
+void CanonicalSearch::searchCell(int cell, Binding &binding) {
+    int row = binding.rows[cell / 9];
+    const uint8_t *source = this->grids[this->transpose][row];
+
+    for(; ; cell++) {
+        int slot = cell % 9, slotStack = slot / 3;
+        int label;
+
+        if(binding.cols[slot] >= 0) {
+            label = this->getLabel(binding, source[binding.cols[slot]], row, slot);
+        } else if(binding.stacks[slotStack] < 0) {
+            uint8_t tried = 0;
+            for(int stack = 0; stack < 3; stack++) {
+                if(binding.stackSlots[stack] >= 0 || this->stackSizes[stack] != this->slotStackSizes[slotStack]) continue;
+                if(this->sameStacks[this->transpose][stack] & tried) continue;
+                tried |= 1 << stack;
+
+                Binding next = binding;
+                this->bindStack(next, stack, slotStack);
+                this->searchCell(cell, next);
+            }
+            return;
+        } else {
+            // Open columns and slots of the stack with a number in the first row where this one has
+            bool number = this->numberSlots & (1 << slot);
+            uint16_t cols = binding.openCols & STACK_MASKS[binding.stacks[slotStack]] & (number ? this->numberCols : ~this->numberCols);
+            uint16_t slots = binding.openSlots & STACK_MASKS[slotStack] & (number ? this->numberSlots : ~this->numberSlots);
+            uint16_t blank = cols & this->blankCols[this->transpose][row];
+
+            if(__builtin_popcount(blank) > __builtin_popcount(slots & ((1 << slot) - 1))) {
+                label = 0;
+            } else {
+                uint16_t tried = 0;
+                for(uint16_t rest = cols & ~blank; rest != 0; rest &= rest - 1) {
+                    int col = __builtin_ctz(rest);
+                    if(this->sameCols[this->transpose][col] & tried) continue;
+                    tried |= 1 << col;
+
+                    Binding next = binding;
+                    this->bindColumn(next, col, slot);
+                    if(this->keepCell(cell, this->getLabel(next, source[col], row, slot))) this->nextCell(cell, next);
+                }
+                return;
+            }
+        }
+
+        if(!this->keepCell(cell, label)) return;
+        if(slot == 8) {
+            this->endRow(cell / 9, binding);
+            return;
+        }
+    }
+}
+
+// Compares a cell with best, false when it's larger
+bool CanonicalSearch::keepCell(int cell, int label) {
+    if(label > this->best[cell]) return false;
+    if(label < this->best[cell]) {
+        this->best[cell] = label;
+        memset(this->best + cell + 1, 0xFF, 80 - cell);
+        this->pendingCount[cell / 9] = 0;
+    }
+    return true;
+}
+
+void CanonicalSearch::nextCell(int cell, Binding &binding) {
+    if(cell % 9 == 8) {
+        this->endRow(cell / 9, binding);
+    } else {
+        this->searchCell(cell + 1, binding);
+    }
+}
+
+// Only reached when the board equals best. What no cell needed goes anywhere it fits
+void CanonicalSearch::finish(Binding &binding) {
+    for(int slotStack = 0; slotStack < 3; slotStack++) {
+        for(int stack = 0; binding.stacks[slotStack] < 0 && stack < 3; stack++) {
+            if(binding.stackSlots[stack] < 0 && this->stackSizes[stack] == this->slotStackSizes[slotStack]) {
+                this->bindStack(binding, stack, slotStack);
+            }
+        }
+    }
+
+    for(int slot = 0; slot < 9; slot++) {
+        if(binding.cols[slot] >= 0) continue;
+        bool number = this->numberSlots & (1 << slot);
+        uint16_t cols = binding.openCols & STACK_MASKS[binding.stacks[slot / 3]] & (number ? this->numberCols : ~this->numberCols);
+        this->bindColumn(binding, __builtin_ctz(cols), slot);
+    }
+
+    this->found.transpose = binding.transpose;
+    memcpy(this->found.rows, binding.rows, 9);
+    memcpy(this->found.cols, binding.cols, 9);
+    memcpy(this->found.digits, binding.labels, 10);
+}
+
+/**
+ * Complete grids take a shorter way. Their first row always comes out 1 to 9 labeled by slot, and
+ * the second row sends every column somewhere, so once it's placed the other rows only need to be
+ * sorted. The second row is searched cell by cell like above, against the smallest one so far,
+ * from the orders of the first stack that can give the smallest second row. Following the column
+ * whose number the second row has, from the first row to the second:
+ * - when the second row holds the numbers of a box of the first row in one of its boxes, every
+ *   column leads to the next stack, the row starts 4 5 6 7 8 9 and three steps lead back to the
+ *   first stack. It ends 1 2 3 when they lead back to the same column, 1 3 2 when they do so for
+ *   one column and swap the others, 2 3 1 when they go round
+ * - otherwise it starts 4 5 7 at best, and 4 5 7 1 8 9 when some column leads to a column that
+ *   leads back to it, in the stack taking two of the numbers of the first one. The row then starts
+ *   at that column, followed by the other one leading to the same stack
+ * - anything else starts 4 5 7 2 or more
+ * Only first and second rows of the best kind are searched.
+*/
+struct GridBinding {
+    int8_t cols[9];         // Source column of every slot, -1 while open
+    int8_t slots[9];        // Slot of every source column, -1 while open
+    int8_t stacks[3];       // Source stack of every output stack, -1 while open
+    int8_t stackSlots[3];   // Output stack of every source stack, -1 while open
+    uint16_t openSlots;
+};
+
+struct GridSearch {
+    uint8_t grids[2][9][9];
+    uint16_t boxNumbers[2][9][3];   // Numbers of every row in every stack, bit number - 1
+
+    bool transpose;
+    uint8_t rows[3];            // First band, the row after the second one is the third one
+    int8_t targets[9];          // Column of the first row holding the number of the second row
+    int8_t numberCols[2][9][10];// Column of every number in every row
+
+    uint8_t best[81];
+    Transform found;
+
+    uint32_t getSecondRow(int t, int first, int second, uint32_t &starts) const;
+    void run();
+    void searchCell(int slot, GridBinding &binding);
+    int getLabel(GridBinding &binding, int slot) const;
+    bool keepCell(int cell, int label);
+    void finish(const GridBinding &binding);
+};
+
+// The smallest second row as a number (456789123 say) and in starts every order of the first
+// stack giving it, bit stack * 6 + order of ORDERS_OF_3. Rows of the last kind are left to the
+// search, from any order
+uint32_t GridSearch::getSecondRow(int t, int first, int second, uint32_t &starts) const {
+    int8_t targets[9];
+    bool pure = false;
+    for(int stack = 0; stack < 3; stack++) {
+        for(int other = 0; other < 3; other++) {
+            pure = pure || this->boxNumbers[t][second][stack] == this->boxNumbers[t][first][other];
+        }
+    }
+    for(int col = 0; col < 9; col++) targets[col] = this->numberCols[t][first][this->grids[t][second][col]];
+
+    starts = 0;
+    if(pure) {
+        // Where three steps lead, as positions in the order of the first stack, for each ending.
+        // They go round the same way from every stack
+        static const uint8_t ENDINGS[3][3] = {{0, 1, 2}, {0, 2, 1}, {1, 2, 0}};
+        int same = 0;
+        for(int col = 0; col < 3; col++) same += targets[targets[targets[col]]] == col;
+        int ending = same == 3 ? 0 : same == 1 ? 1 : 2;
+
+        for(int stack = 0; stack < 3; stack++) {
+            for(int order = 0; order < 6; order++) {
+                const uint8_t *cols = ORDERS_OF_3[order];
+                bool fits = true;
+                for(int k = 0; k < 3; k++) {
+                    fits = fits && targets[targets[targets[stack * 3 + cols[k]]]] == stack * 3 + cols[ENDINGS[ending][k]];
+                }
+                if(fits) starts |= 1 << (stack * 6 + order);
+            }
+        }
+        return 456789000 + (ENDINGS[ending][0] + 1) * 100 + (ENDINGS[ending][1] + 1) * 10 + ENDINGS[ending][2] + 1;
+    }
+
+    uint32_t smallest = 1000000000;
+    for(int col = 0; col < 9; col++) {
+        int target = targets[col], stack = col / 3;
+        if(targets[target] != col) continue;
+
+        int next = -1, last = -1;
+        for(int other = stack * 3; other < stack * 3 + 3; other++) {
+            if(other == col) continue;
+            if(targets[other] / 3 == target / 3) next = other;
+            else last = other;
+        }
+        // The stack the column leads to has to take two numbers of its stack
+        if(next < 0 || last < 0) continue;
+
+        // Slots the second row gives every column when it starts at this one, as getLabel would
+        int8_t slots[9];
+        int rest = target / 3 * 9 + 3 - target - targets[next];
+        slots[col] = 0;
+        slots[next] = 1;
+        slots[last] = 2;
+        slots[target] = 3;
+        slots[targets[next]] = 4;
+        slots[rest] = 5;
+        slots[targets[last]] = 6;
+        slots[targets[targets[next]]] = 7;
+        slots[targets[rest]] = 8;
+        uint32_t row = 457189000 + (slots[targets[targets[last]]] + 1) * 100 + (slots[targets[targets[targets[next]]]] + 1) * 10 + slots[targets[targets[rest]]] + 1;
+
+        if(row < smallest) {
+            smallest = row;
+            starts = 0;
+        }
+        if(row == smallest) starts |= 1 << (stack * 6 + (col % 3) * 2 + (next % 3 > last % 3));
+    }
+    if(starts != 0) return smallest;
+
+    starts = (1 << 18) - 1;
+    return smallest;
+}
+
+void GridSearch::run() {
+    for(int t = 0; t < 2; t++) {
+        for(int row = 0; row < 9; row++) {
+            for(int col = 0; col < 9; col++) this->numberCols[t][row][this->grids[t][row][col]] = col;
+            for(int stack = 0; stack < 3; stack++) {
+                this->boxNumbers[t][row][stack] = 0;
+                for(int col = stack * 3; col < stack * 3 + 3; col++) {
+                    this->boxNumbers[t][row][stack] |= 1 << (this->grids[t][row][col] - 1);
+                }
+            }
+        }
+    }
+
+    uint32_t secondRows[2][9][3], starts[2][9][3];
+    uint32_t smallest = 1000000000;
+    for(int t = 0; t < 2; t++) {
+        for(int first = 0; first < 9; first++) {
+            for(int i = 0; i < 3; i++) {
+                int second = first / 3 * 3 + i;
+                secondRows[t][first][i] = second == first ? ~0u : this->getSecondRow(t, first, second, starts[t][first][i]);
+                smallest = std::min(smallest, secondRows[t][first][i]);
+            }
+        }
+    }
+
+    memset(this->best, 0xFF, sizeof(this->best));
+    for(int slot = 0; slot < 9; slot++) this->best[slot] = slot + 1;
+
+    for(int t = 0; t < 2; t++) {
+        for(int first = 0; first < 9; first++) {
+            for(int second = first / 3 * 3; second < first / 3 * 3 + 3; second++) {
+                if(secondRows[t][first][second % 3] != smallest) continue;
+
+                this->transpose = t;
+                this->rows[0] = first;
+                this->rows[1] = second;
+                this->rows[2] = first / 3 * 9 + 3 - first - second;
+                for(int col = 0; col < 9; col++) this->targets[col] = this->numberCols[t][first][this->grids[t][second][col]];
+
+                for(uint32_t rest = starts[t][first][second % 3]; rest != 0; rest &= rest - 1) {
+                    int start = __builtin_ctz(rest), stack = start / 6;
+                    const uint8_t *order = ORDERS_OF_3[start % 6];
+
+                    GridBinding binding;
+                    memset(binding.stacks, -1, sizeof(binding.stacks));
+                    memset(binding.stackSlots, -1, sizeof(binding.stackSlots));
+                    memset(binding.slots, -1, sizeof(binding.slots));
+                    memset(binding.cols, -1, sizeof(binding.cols));
+                    binding.stacks[0] = stack;
+                    binding.stackSlots[stack] = 0;
+                    for(int slot = 0; slot < 3; slot++) {
+                        binding.cols[slot] = stack * 3 + order[slot];
+                        binding.slots[stack * 3 + order[slot]] = slot;
+                    }
+                    binding.openSlots = 0x1F8;
+                    this->searchCell(0, binding);
+                }
+            }
+        }
+    }
+}
+
+// Goes through the rest of the second row from slot, like CanonicalSearch::searchCell
+void GridSearch::searchCell(int slot, GridBinding &binding) {
+    for(; slot < 9; slot++) {
+        int slotStack = slot / 3;
+
+        if(binding.stacks[slotStack] < 0) {
+            for(int stack = 0; stack < 3; stack++) {
+                if(binding.stackSlots[stack] >= 0) continue;
+
+                GridBinding next = binding;
+                next.stacks[slotStack] = stack;
+                next.stackSlots[stack] = slotStack;
+                this->searchCell(slot, next);
+            }
+            return;
+        }
+
+        if(binding.cols[slot] < 0) {
+            for(int col = binding.stacks[slotStack] * 3; col < binding.stacks[slotStack] * 3 + 3; col++) {
+                if(binding.slots[col] >= 0) continue;
+
+                GridBinding next = binding;
+                next.cols[slot] = col;
+                next.slots[col] = slot;
+                next.openSlots &= ~(1 << slot);
+                if(this->keepCell(9 + slot, this->getLabel(next, slot))) this->searchCell(slot + 1, next);
+            }
+            return;
+        }
+
+        if(!this->keepCell(9 + slot, this->getLabel(binding, slot))) return;
+    }
+
+    this->finish(binding);
+}
+
+// Label of the cell in slot, the number is the one of the first row whose column takes the
+// first slot it can when it's still open
+int GridSearch::getLabel(GridBinding &binding, int slot) const {
+    int col = this->targets[binding.cols[slot]];
+
+    if(binding.slots[col] < 0) {
+        int stack = col / 3;
+        if(binding.stackSlots[stack] < 0) {
+            int slotStack = binding.stacks[0] < 0 ? 0 : binding.stacks[1] < 0 ? 1 : 2;
+            binding.stacks[slotStack] = stack;
+            binding.stackSlots[stack] = slotStack;
+        }
+
+        int free = __builtin_ctz(binding.openSlots & STACK_MASKS[binding.stackSlots[stack]]);
+        binding.cols[free] = col;
+        binding.slots[col] = free;
+        binding.openSlots &= ~(1 << free);
+    }
+
+    return binding.slots[col] + 1;
+}
+
+bool GridSearch::keepCell(int cell, int label) {
+    if(label > this->best[cell]) return false;
+    if(label < this->best[cell]) {
+        this->best[cell] = label;
+        memset(this->best + cell + 1, 0xFF, 80 - cell);
+    }
+    return true;
+}
+
+// The second row placed every column. The third row follows, the other bands come sorted by
+// their first row and hold their rows sorted
+void GridSearch::finish(const GridBinding &binding) {
+    const uint8_t (*grid)[9] = this->grids[this->transpose];
+    uint8_t labels[10];
+    labels[0] = 0;
+    for(int col = 0; col < 9; col++) labels[grid[this->rows[0]][col]] = binding.slots[col] + 1;
+
+    // Most second rows tied with best already lose on the third one
+    uint8_t board[63];
+    int third = 0;
+    for(int slot = 0; slot < 9; slot++) {
+        board[slot] = labels[grid[this->rows[2]][binding.cols[slot]]];
+        if(third == 0) third = board[slot] - this->best[18 + slot];
+        if(third > 0) return;
+    }
+
+    uint8_t rest[6][9];
+    uint8_t restRows[6];
+    for(int band = 0, count = 0; band < 3; band++) {
+        if(band == this->rows[0] / 3) continue;
+        for(int row = band * 3; row < band * 3 + 3; row++, count++) {
+            restRows[count] = row;
+            for(int slot = 0; slot < 9; slot++) rest[count][slot] = labels[grid[row][binding.cols[slot]]];
+        }
+    }
+
+    // Insertion sort of the rows within both bands, then of the bands by their first row
+    int order[6] = {0, 1, 2, 3, 4, 5};
+    for(int band = 0; band < 6; band += 3) {
+        for(int i = band + 1; i < band + 3; i++) {
+            for(int j = i; j > band && memcmp(rest[order[j]], rest[order[j - 1]], 9) < 0; j--) std::swap(order[j], order[j - 1]);
+        }
+    }
+    if(memcmp(rest[order[3]], rest[order[0]], 9) < 0) {
+        for(int i = 0; i < 3; i++) std::swap(order[i], order[i + 3]);
+    }
+
+    for(int i = 0; i < 6; i++) memcpy(board + 9 + i * 9, rest[order[i]], 9);
+    if(third == 0 && memcmp(board + 9, this->best + 27, 54) >= 0) return;
+    memcpy(this->best + 18, board, 63);
+
+    this->found.transpose = this->transpose;
+    memcpy(this->found.rows, this->rows, 3);
+    for(int i = 0; i < 6; i++) this->found.rows[i + 3] = restRows[order[i]];
+    memcpy(this->found.cols, binding.cols, 9);
+    memcpy(this->found.digits, labels, 10);
+}
+
+// Every row, column and box holds every number
+static bool isCompleteGrid(const uint8_t grid[9][9]) {
+    for(int i = 0; i < 9; i++) {
+        uint16_t row = 0, col = 0, box = 0;
+        for(int j = 0; j < 9; j++) {
+            row |= 1 << grid[i][j];
+            col |= 1 << grid[j][i];
+            box |= 1 << grid[i / 3 * 3 + j / 3][i % 3 * 3 + j % 3];
+        }
+        if(row != 0x3FE || col != 0x3FE || box != 0x3FE) return false;
+    }
+    return true;
+}
+
+Transform randomTransform(Random &random) {
+    Transform transform;
+    transform.transpose = random.below(2) == 1;
+
+    const uint8_t *bands = ORDERS_OF_3[random.below(6)];
+    const uint8_t *stacks = ORDERS_OF_3[random.below(6)];
+    for(int k = 0; k < 3; k++) {
+        const uint8_t *rows = ORDERS_OF_3[random.below(6)];
+        const uint8_t *cols = ORDERS_OF_3[random.below(6)];
+        for(int i = 0; i < 3; i++) {
+            transform.rows[k * 3 + i] = bands[k] * 3 + rows[i];
+            transform.cols[k * 3 + i] = stacks[k] * 3 + cols[i];
+        }
+    }
+
+    transform.digits[0] = 0;
+    for(int number = 1; number <= 9; number++) { transform.digits[number] = number; }
+    for(int number = 9; number > 1; number--) {
+        int other = random.below(number) + 1;
+        uint8_t tmp = transform.digits[number];
+        transform.digits[number] = transform.digits[other];
+        transform.digits[other] = tmp;
+    }
+
+    return transform;
+}
+
+Sudoku applyTransform(const Sudoku &sudoku, const Transform &transform) {
+    int grid[9][9];
+    for(int i = 0; i < 9; i++) {
+        for(int j = 0; j < 9; j++) {
+            int row = transform.rows[i];
+            int col = transform.cols[j];
+            int number = transform.transpose ? sudoku.getItem(col, row) : sudoku.getItem(row, col);
+            grid[i][j] = transform.digits[number];
+        }
+    }
+    return Sudoku(grid);
+}
+
+void CanonicalSearch::run() {
+    memset(this->best, 0xFF, sizeof(this->best));
+
+    // The first row can only be one whose best pattern is the smallest of all
+    int patterns[2][9];
+    int smallest = 0x1FF;
+    for(int t = 0; t < 2; t++) {
+        for(int row = 0; row < 9; row++) {
+            patterns[t][row] = bestRowPattern(this->grids[t][row]);
+            smallest = std::min(smallest, patterns[t][row]);
+        }
+    }
+
+    this->compare();
+    this->pendingCount[1] = 0;
+    for(int t = 0; t < 2; t++) {
+        this->transpose = t;
+
+        uint16_t tried = 0;
+        for(int row = 0; row < 9; row++) {
+            if(patterns[t][row] != smallest || (this->sameRows[t][row] | this->sameBandRows[t][row]) & tried) continue;
+            tried |= 1 << row;
+            this->start(row);
+        }
+    }
+    this->descend(1);
+}
+
+// Fills a search with the board and its transposition, runs it and reads back the result
+template <class Search>
+static void runSearch(Search &search, const uint8_t grid[9][9], uint8_t best[81], Transform *transform) {
+    for(int i = 0; i < 9; i++) {
+        for(int j = 0; j < 9; j++) {
+            search.grids[0][i][j] = grid[i][j];
+            search.grids[1][j][i] = grid[i][j];
+        }
+    }
+    search.run();
+    memcpy(best, search.best, 81);
+
+    if(transform != NULL) {
+        *transform = search.found;
+
+        // Numbers missing from the board still need a label of their own
+        int lastDigit = *std::max_element(transform->digits, transform->digits + 10);
+        for(int number = 1; number <= 9; number++) {
+            if(transform->digits[number] == 0) transform->digits[number] = ++lastDigit;
+        }
+    }
+}
+
+// Canonical form as 81 cells, row by row
+static void findCanonical(const Sudoku &sudoku, uint8_t best[81], Transform *transform) {
+    uint8_t grid[9][9];
+    for(int i = 0; i < 9; i++) {
+        for(int j = 0; j < 9; j++) grid[i][j] = sudoku.getItem(i, j);
+    }
+
+    if(isCompleteGrid(grid)) {
+        GridSearch search;
+        runSearch(search, grid, best, transform);
+    } else {
+        CanonicalSearch search;
+        runSearch(search, grid, best, transform);
+    }
+}
+
+Sudoku canonicalForm(const Sudoku &sudoku, Transform *transform) {
+    uint8_t best[81];
+    findCanonical(sudoku, best, transform);
+
+    int grid[9][9];
+    for(int i = 0; i < 9; i++) {
+        for(int j = 0; j < 9; j++) grid[i][j] = best[i * 9 + j];
+    }
+    return Sudoku(grid);
+}
+
+// FNV-1a over the 81 cells of the canonical form, taken straight from the search
+uint64_t canonicalHash(const Sudoku &sudoku) {
+    uint8_t best[81];
+    findCanonical(sudoku, best, NULL);
+
+    uint64_t hash = 14695981039346656037ULL;
+    for(int i = 0; i < 81; i++) {
+        hash ^= (uint64_t) best[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
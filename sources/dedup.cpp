@@ -0,0 +1,90 @@
+#include "../headers/dedup.h"
+#include "../headers/canonical.h"
+#include "../headers/hash_set.h"
+#include "../headers/line_pipeline.h"
+#include <cstdio>
+#include <vector>
+
+struct DedupLine {
+    size_t position;
+    size_t length;
+    uint64_t hash;
+    bool valid;
+};
+
+struct DedupChunk : LineChunk {
+    std::vector <DedupLine> lines;
+};
+
+static LineChunk* createChunk() {
+    return new DedupChunk();
+}
+
+static void hashChunk(LineChunk *base) {
+    DedupChunk *chunk = static_cast<DedupChunk*>(base);
+    Sudoku sudoku;
+
+    forEachLine(chunk->input, [&](size_t position, size_t length) {
+        DedupLine line;
+        line.position = position;
+        line.length = length;
+        line.valid = length == 81 && sudoku.loadString(&chunk->input[position]);
+        line.hash = line.valid ? canonicalHash(sudoku) : 0;
+        chunk->lines.push_back(line);
+    });
+}
+
+int runDedup(const std::string &path, int threads, const std::string &indexPath) {
+    HashSet index;
+    if(!indexPath.empty()) {
+        FILE *file = fopen(indexPath.c_str(), "rb");
+        if(file != NULL) {
+            bool loaded = index.load(file);
+            fclose(file);
+            if(!loaded) {
+                fprintf(stderr, "Can't read %s\n", indexPath.c_str());
+                return 1;
+            }
+        }
+    }
+    long indexed = index.size();
+
+    long boards = 0;
+    long kept = 0;
+    long invalid = 0;
+
+    // Looks up the hashes in input order, so the first of equal boards is kept
+    auto lookUp = [&](LineChunk *base) {
+        DedupChunk *chunk = static_cast<DedupChunk*>(base);
+        for(size_t i = 0; i < chunk->lines.size(); i++) {
+            const DedupLine &line = chunk->lines[i];
+            boards++;
+            if(!line.valid) {
+                invalid++;
+            } else if(index.insert(line.hash)) {
+                fwrite(&chunk->input[line.position], 1, line.length, stdout);
+                fputc('\n', stdout);
+                kept++;
+            }
+        }
+    };
+
+    LineRun run;
+    if(!runLinePipeline(path, threads, createChunk, hashChunk, lookUp, run)) return 1;
+
+    fprintf(stderr, "Kept %ld of %ld boards (%ld duplicates, %ld invalid) in %.3f s (%.0f boards/s, %d threads)\n",
+        kept, boards, boards - kept - invalid, invalid, run.seconds, run.getRate(boards), run.threads);
+
+    if(!indexPath.empty()) {
+        FILE *file = fopen(indexPath.c_str(), "wb");
+        bool saved = file != NULL && index.save(file);
+        if(file != NULL && fclose(file) != 0) saved = false;
+        if(!saved) {
+            fprintf(stderr, "Can't write %s\n", indexPath.c_str());
+            return 1;
+        }
+        fprintf(stderr, "Index %s: %ld hashes (%ld new)\n", indexPath.c_str(), index.size(), index.size() - indexed);
+    }
+
+    return 0;
+}
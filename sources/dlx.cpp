@@ -0,0 +1,184 @@
+#include "../headers/dlx.h"
+#include "../headers/stats.h"
+
+DlxSolver::DlxSolver() {
+    // Column headers, linked in a circular list with the root
+    for(int i = 0; i <= COLUMNS; i++) {
+        this->left[i] = i - 1;
+        this->right[i] = i + 1;
+        this->up[i] = i;
+        this->down[i] = i;
+        this->column[i] = i;
+        this->rowId[i] = -1;
+        this->size[i] = 0;
+        this->covered[i] = false;
+    }
+    this->left[ROOT] = COLUMNS;
+    this->right[COLUMNS] = ROOT;
+
+    int next = COLUMNS + 1;
+    for(int row = 0; row < ROWS; row++) {
+        int cell = row / 9;
+        int number = row % 9;
+        int r = cell / 9;
+        int c = cell % 9;
+        int b = (r / 3) * 3 + c / 3;
+
+        int columns[4] = {
+            1 + cell,
+            1 + 81 + r * 9 + number,
+            1 + 162 + c * 9 + number,
+            1 + 243 + b * 9 + number
+        };
+
+        this->rowStart[row] = next;
+        for(int k = 0; k < 4; k++) {
+            int node = next + k;
+            int col = columns[k];
+
+            this->column[node] = col;
+            this->rowId[node] = row;
+
+            this->up[node] = this->up[col];
+            this->down[node] = col;
+            this->down[this->up[col]] = node;
+            this->up[col] = node;
+            this->size[col]++;
+
+            this->left[node] = next + (k + 3) % 4;
+            this->right[node] = next + (k + 1) % 4;
+        }
+        next += 4;
+    }
+}
+
+const char* DlxSolver::getName() {
+    return "dlx";
+}
+
+void DlxSolver::cover(int col) {
+    this->right[this->left[col]] = this->right[col];
+    this->left[this->right[col]] = this->left[col];
+
+    for(int i = this->down[col]; i != col; i = this->down[i]) {
+        for(int j = this->right[i]; j != i; j = this->right[j]) {
+            this->down[this->up[j]] = this->down[j];
+            this->up[this->down[j]] = this->up[j];
+            this->size[this->column[j]]--;
+        }
+    }
+    this->covered[col] = true;
+}
+
+void DlxSolver::uncover(int col) {
+    for(int i = this->up[col]; i != col; i = this->up[i]) {
+        for(int j = this->left[i]; j != i; j = this->left[j]) {
+            this->size[this->column[j]]++;
+            this->down[this->up[j]] = j;
+            this->up[this->down[j]] = j;
+        }
+    }
+
+    this->right[this->left[col]] = col;
+    this->left[this->right[col]] = col;
+    this->covered[col] = false;
+}
+
+// Covers every column of a candidate row given by the puzzle.
+// Returns false (and changes nothing) when one of them is already taken by another given
+bool DlxSolver::selectRow(int row) {
+    int start = this->rowStart[row];
+
+    for(int k = 0; k < 4; k++) {
+        if(this->covered[this->column[start + k]]) return false;
+    }
+
+    for(int k = 0; k < 4; k++) {
+        this->cover(this->column[start + k]);
+    }
+    return true;
+}
+
+void DlxSolver::unselectRow(int row) {
+    int start = this->rowStart[row];
+
+    for(int k = 3; k >= 0; k--) {
+        this->uncover(this->column[start + k]);
+    }
+}
+
+// Every cover is undone on the way back, also after a solution was found,
+// so the matrix is ready for the next puzzle
+bool DlxSolver::search(int depth, int &solvedDepth) {
+    if(this->right[ROOT] == ROOT) {
+        solvedDepth = depth;
+        return true;
+    }
+
+    // Column with the fewest remaining rows
+    int col = this->right[ROOT];
+    for(int i = this->right[col]; i != ROOT; i = this->right[i]) {
+        if(this->size[i] < this->size[col]) col = i;
+    }
+
+    if(this->size[col] == 0) return false;
+
+    STATS_MAX(maxDepth, depth + 1);
+    this->cover(col);
+
+    bool found = false;
+    for(int r = this->down[col]; r != col && !found; r = this->down[r]) {
+        this->solution[depth] = this->rowId[r];
+        STATS_ADD(nodes, 1);
+
+        for(int j = this->right[r]; j != r; j = this->right[j]) {
+            this->cover(this->column[j]);
+        }
+
+        found = this->search(depth + 1, solvedDepth);
+
+        for(int j = this->left[r]; j != r; j = this->left[j]) {
+            this->uncover(this->column[j]);
+        }
+        if(!found) STATS_ADD(backtracks, 1);
+    }
+
+    this->uncover(col);
+    return found;
+}
+
+bool DlxSolver::solve(Sudoku &sudoku) {
+    int given[81];
+    int givenCount = 0;
+    bool solved = true;
+
+    for(int cell = 0; cell < 81 && solved; cell++) {
+        int number = sudoku.getItem(cell / 9, cell % 9);
+        if(number < 1 || number > 9) continue;
+
+        int row = cell * 9 + number - 1;
+        if(this->selectRow(row)) {
+            given[givenCount++] = row;
+        } else {
+            solved = false;
+        }
+    }
+
+    int solvedDepth = 0;
+    if(solved) {
+        solved = this->search(0, solvedDepth);
+    }
+
+    if(solved) {
+        for(int i = 0; i < solvedDepth; i++) {
+            int cell = this->solution[i] / 9;
+            sudoku.setItem(cell / 9, cell % 9, this->solution[i] % 9 + 1);
+        }
+    }
+
+    for(int i = givenCount - 1; i >= 0; i--) {
+        this->unselectRow(given[i]);
+    }
+
+    return solved;
+}
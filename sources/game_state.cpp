@@ -0,0 +1,114 @@
+#include "../headers/game_state.h"
+#include <cstring>
+
+static int boxOf(int cell) {
+    return (cell / 27) * 3 + (cell % 9) / 3;
+}
+
+GameState::GameState(const Sudoku &puzzle, const Sudoku &solution) {
+    this->reset(puzzle, solution);
+}
+
+void GameState::reset(const Sudoku &puzzle, const Sudoku &solution) {
+    memset(this->rowCount, 0, sizeof(this->rowCount));
+    memset(this->colCount, 0, sizeof(this->colCount));
+    memset(this->boxCount, 0, sizeof(this->boxCount));
+    this->correct = 0;
+    this->mistakes = 0;
+    this->position = 0;
+    this->journal.clear();
+
+    for(int cell = 0; cell < 81; cell++) {
+        this->value[cell] = 0;
+        this->solution[cell] = solution.getItem(cell / 9, cell % 9);
+        this->given[cell] = puzzle.getItem(cell / 9, cell % 9) != 0;
+        this->apply(cell, puzzle.getItem(cell / 9, cell % 9));
+    }
+}
+
+// Replaces the number of a cell and updates the counters, the only place that writes value
+void GameState::apply(int cell, int number) {
+    int row = cell / 9, col = cell % 9, box = boxOf(cell);
+    int previous = this->value[cell];
+
+    if(previous != 0) {
+        this->rowCount[row][previous]--;
+        this->colCount[col][previous]--;
+        this->boxCount[box][previous]--;
+    }
+    if(previous == this->solution[cell]) this->correct--;
+
+    this->value[cell] = number;
+
+    if(number != 0) {
+        this->rowCount[row][number]++;
+        this->colCount[col][number]++;
+        this->boxCount[box][number]++;
+    }
+    if(number == this->solution[cell]) this->correct++;
+}
+
+int GameState::getItem(int row, int col) {
+    return this->value[row * 9 + col];
+}
+
+bool GameState::isGiven(int row, int col) {
+    return this->given[row * 9 + col];
+}
+
+bool GameState::isWrong(int row, int col) {
+    int cell = row * 9 + col;
+    return this->value[cell] != 0 && this->value[cell] != this->solution[cell];
+}
+
+bool GameState::isConflict(int row, int col) {
+    int cell = row * 9 + col;
+    int number = this->value[cell];
+    if(number == 0) return false;
+
+    return this->rowCount[row][number] > 1 || this->colCount[col][number] > 1 || this->boxCount[boxOf(cell)][number] > 1;
+}
+
+bool GameState::isWon() {
+    return this->correct == 81;
+}
+
+int GameState::getMistakes() {
+    return this->mistakes;
+}
+
+bool GameState::setItem(int row, int col, int number) {
+    int cell = row * 9 + col;
+    if(this->given[cell] || this->value[cell] == number) return false;
+
+    // A new move drops the moves that were undone
+    this->journal.resize(this->position);
+
+    Move move;
+    move.cell = cell;
+    move.before = this->value[cell];
+    move.after = number;
+    this->journal.push_back(move);
+    this->position++;
+
+    this->apply(cell, number);
+    if(this->isWrong(row, col)) this->mistakes++;
+
+    return true;
+}
+
+bool GameState::undo() {
+    if(this->position == 0) return false;
+
+    const Move &move = this->journal[--this->position];
+    this->apply(move.cell, move.before);
+    return true;
+}
+
+bool GameState::redo() {
+    if(this->position == this->journal.size()) return false;
+
+    const Move &move = this->journal[this->position++];
+    this->apply(move.cell, move.after);
+    return true;
+}
@@ -0,0 +1,322 @@
+#include "../headers/generator.h"
+#include "../headers/canonical.h"
+#include "../headers/grader.h"
+#include "../headers/iterative.h"
+#include "../headers/stats.h"
+#include <algorithm>
+
+static const int RESTORED_CLUES = 8;    // Clues put back into a puzzle short of its level before blanking it again
+static const int REWORK_ATTEMPTS = 32;  // Reworks of one grid before starting over from a fresh one
+static const int CLOSENESS_PER_LEVEL = 16;
+static const int VARIANT_GRIDS = 4;     // Fresh grids a variant puzzle gets, some rules rarely or never make the level
+
+static const uint64_t SEED_BITS = (1ULL << 62) - 1;
+
+Puzzle::Puzzle(uint64_t id, const Sudoku &solution, const Sudoku &puzzle) : id(id), solution(solution), puzzle(puzzle) {}
+
+uint64_t makePuzzleId(int level, uint64_t seed) {
+    return ((uint64_t) level << 62) | (seed & SEED_BITS);
+}
+
+int getPuzzleLevel(uint64_t id) {
+    return (int) (id >> 62);
+}
+
+/**
+ * Full grids every generated grid is shuffled from, one picked at random each time. They are random
+ * solutions written in canonical form (see canonicalForm), so no two of them are the same grid up
+ * to a transform, and none has the regular structure of a grid built from shifted rows.
+*/
+static const char *const BASE_GRIDS[] = {
+    "123456789457189236698237145246793851715842693839615472382571964564928317971364528",
+    "123456789456789123789132564237695841594813672861274395378941256645327918912568437",
+    "123456789457189236689732415264873951715964328938521647392615874576248193841397562",
+    "123456789457189236698327415281573694379642158564891372712968543846735921935214867",
+    "123456789457189263896372451239617845645823197718945632372568914584791326961234578",
+    "123456789457189236689723415296534871531867924748912563314275698875691342962348157",
+    "123456789457189236689723514248315697316972458795864123564298371831547962972631845",
+    "123456789457189263689273154216837945735942816948615372372561498594728631861394527",
+    "123456789457189236689237451268315974314972865975864123542698317791523648836741592",
+    "123456789457189236689327514291674853375298461846531972562843197734915628918762345",
+    "123456789457189236689723541271368495396574128548291367762945813814637952935812674",
+    "123456789456789123789123465237841956594672318618935274345218697861397542972564831",
+    "123456789456789123789132564241973658395861247678245931517324896864597312932618475",
+    "123456789456789132789231564215394876348672951967518423572143698691825347834967215",
+    "123456789457189236698273415261937854385614927749825361536792148872541693914368572",
+    "123456789457189236689372154216593478734618925895724361371965842548231697962847513",
+    "123456789457189263698327451235718946764935812981264537342571698576893124819642375",
+    "123456789456789132789213645238195476567324891941678523315947268672831954894562317",
+    "123456789457189236689327451291563847376842915845791623518974362732618594964235178",
+    "123456789456789123798132465214597638865324971937861254379248516542613897681975342",
+    "123456789456789132789132564265841397874593621931627458317968245592314876648275913",
+    "123456789457189236698327541274935618519862473836714952365241897782593164941678325",
+    "123456789457189236689237514236541897791628453845793621368975142514362978972814365",
+    "123456789457189236689372451238965174594731862761248593372894615815623947946517328",
+    "123456789457189236689732415298317654376245891541968372714693528862571943935824167",
+    "123456789457189236689327415236945178748613952915278364391564827572891643864732591",
+    "123456789456789132789132564245693817378214956961578243594867321617325498832941675",
+    "123456789457189236896723154285314697631975842749862315312547968568291473974638521",
+    "123456789457189236689273154264598317571364892938721645395612478716845923842937561",
+    "123456789457189236689273154271368495865914372934527618312845967546791823798632541",
+    "123456789456789123897231564215894376648317952739625418364178295581942637972563841",
+    "123456789457189236689372154296518347514793862738624915375961428861247593942835671",
+    "123456789457189263689273451274861935396547128518932674761395842832614597945728316",
+    "123456789457189236869273154285934617734861925916527348392748561541692873678315492",
+    "123456789456789123789132564274395618591648372638271945312964857847513296965827431",
+    "123456789457189236698723145279361854365847921841592367582914673716235498934678512",
+    "123456789457189236896237154245768391369521478781943625518672943674395812932814567",
+    "123456789457189236689732415248397651531864972976215348395678124764521893812943567",
+    "123456789456789132789213456261937548874165923935842617317598264598624371642371895",
+    "123456789457189236689327145296835417548761923731294658372648591865912374914573862",
+    "123456789457189236896237514289743651634521978715698342341965827562874193978312465",
+    "123456789456789132789132564218564397674913258935827641367248915542691873891375426",
+    "123456789456789123798132546234615897861927354975348261312894675547261938689573412",
+    "123456789456789123798231564219375846387624951645918237561847392834192675972563418",
+    "123456789457189263689723451265348917371692548948517632596231874732864195814975326",
+    "123456789456789123798132564264317895319568472587294631631825947875943216942671358",
+    "123456789456789231789132546267814953345297618918365427591643872632578194874921365",
+    "123456789456789123798132546261345897835297461974861352349678215517924638682513974",
+    "123456789457189236869723154274815963395642871681397425518234697732961548946578312",
+    "123456789457189236689732154214397568368245971975618423596824317741563892832971645",
+    "123456789457189263986327451269738514538641972741592638395864127612973845874215396",
+    "123456789456789231789312456214693578398275614675148392562831947837964125941527863",
+    "123456789457189236689273415234968157596741823718325694375814962862597341941632578",
+    "123456789456789123789132564278963451315874692964215837542691378697348215831527946",
+    "123456789457189236698273415234761958876935124915824673341592867582647391769318542",
+    "123456789457189236968372154235897461619234578784561392391625847572948613846713925",
+    "123456789456789231789132546215364897637895124948217365364578912591623478872941653",
+    "123456789457189236689273541271634958835792614964815372396541827548927163712368495",
+    "123456789457189236698237541236915874814372965975648123349721658562894317781563492",
+    "123456789457189263689372154214597638735861942896243571378915426541628397962734815",
+    "123456789456789123798132564274518936531694278689273451347965812812347695965821347",
+    "123456789457189236698273154284517693316894527579362841741925368835641972962738415",
+    "123456789457189236689327451248635917391748625576291843714562398835974162962813574",
+    "123456789456789132879231564237165498681924357945378216368542971514897623792613845",
+    "123456789457189236689732154245318697731694528896275341362841975518927463974563812",
+    "123456789457189236689723415214635897836917542975842163342568971591374628768291354",
+    "123456789456789132789213654214375968368194275597628341632841597875962413941537826",
+    "123456789456789132789231564231574896594168273678392415345917628812643957967825341",
+    "123456789457189236689732514264873951715924368938615427396241875571398642842567193",
+    "123456789457189236869723154278695413345217698691834527586342971712968345934571862",
+    "123456789456789132789213456234867915617935824895124367378642591542391678961578243",
+    "123456789456789132789213456274168593361975248895342671518634927642897315937521864",
+    "123456789457189263689732154235697841871524396964813527396275418548361972712948635",
+    "123456789456789123789231645214563897598174362637928514362845971871392456945617238",
+    "123456789456789132789132564218347956537968421694215378365894217842571693971623845",
+    "123456789457189263689273415276391854314825976598647132741532698865914327932768541",
+    "123456789456789123798213654234567918617948235985132467362874591549321876871695342",
+    "123456789457189236689372415238567194745913628916248357362795841571824963894631572",
+    "123456789456789123798132546231674958647895312985321674319247865562918437874563291",
+    "123456789457189236698372154265813947384967512971245368536724891719638425842591673",
+    "123456789457189236869327415296518347381794652745263891518642973674935128932871564",
+    "123456789456789123897231645234815976571962438968374251389127564642593817715648392",
+    "123456789457189236689372541268935417531647928794821365345718692876293154912564873",
+    "123456789457189263698732145241567938369218574875394612582673491734921856916845327",
+    "123456789457189236689723541214837695536914827978562314365241978742698153891375462",
+    "123456789456789132789132546214697358395814627678325491537968214841273965962541873",
+    "123456789457189236689237451231568974548971362796342815315824697862795143974613528",
+    "123456789457189236968372154239567841584291673716834925391725468675948312842613597",
+    "123456789457189236986237154298573641631824975745691823372965418564718392819342567",
+    "123456789457189236689372154214793568368514927975268413546827391792631845831945672",
+    "123456789456789132789132564217348956538967241964215873392574618671823495845691327",
+    "123456789457189236869732154286573491574918623931264578395621847642897315718345962",
+    "123456789457189236869237514275841693341695872986372145592714368618923457734568921",
+    "123456789456789132789231546267814395845397621931625874312548967574963218698172453",
+    "123456789457189236689732514236874951571923468948561327314695872762348195895217643",
+    "123456789457189236896273514238547691645891372971632845312764958569318427784925163",
+    "123456789456789132789231564241873956638925417975164328312697845567348291894512673",
+    "123456789456789132789132564278695413564813927931247658315924876692578341847361295",
+    "123456789457189236689723145231975468875264391946318572314692857592837614768541923",
+    "123456789457189236689372154295761843368245917741893625574618392836924571912537468",
+    "123456789456789123798132546265974318314825697879613254542368971687591432931247865",
+    "123456789456789123798132546214397865379568214685241937561924378837615492942873651",
+    "123456789457189236986327154274835691639714528815692347341268975568973412792541863",
+    "123456789457189263689237415241795836395864127876312954564928371738641592912573648",
+    "123456789457189236689273514276314958395867142841592367532748691764931825918625473",
+    "123456789457189236968273514219345678386927145574861923635714892742598361891632457",
+    "123456789457189236689372514238764195564913827971528643316895472795241368842637951",
+    "123456789457189236689723415216975843538214967794368521371542698845691372962837154",
+    "123456789457189236698327145249738561735691824816245397361874952572963418984512673",
+    "123456789457189236689732154298673541364521978715948362541897623836215497972364815",
+    "123456789457189236896237154279863415548921367631745928384572691712698543965314872",
+    "123456789457189236689723415248537691396841527571692843712368954834975162965214378",
+    "123456789457189236869327415285614397716893542934275861371942658548761923692538174",
+    "123456789457189263698327154234918675561742938879563412342871596786295341915634827",
+    "123456789457189236689237415235648197761923548894571362318792654576814923942365871",
+    "123456789457189236689327451218795364365214897794638125531942678872561943946873512",
+    "123456789457189236968237154295678413631924875784315692376541928519862347842793561",
+    "123456789457189236698723514236597148574618392819234675385972461742861953961345827",
+    "123456789457189236689372154238641597571928643946735812364517928712894365895263471",
+    "123456789457189236689732514241678953365941827798523641536894172812367495974215368",
+    "123456789457189236689723514236591847518647923974238165391874652765312498842965371",
+    "123456789456789132789123546218647395367591824594238671632814957841975263975362418",
+    "123456789457189236698723415239874561765291348841635927382967154574318692916542873",
+    "123456789457189236689723415291875643546391872738264951372618594815942367964537128",
+    "123456789456789132789132564261893475395674821847215396534968217618527943972341658",
+    "123456789456789231798213645237691854514328976869547312382165497675934128941872563",
+    "123456789457189236689372145271894653394765812568231974732948561816523497945617328",
+    "123456789456789132789132564271395648538264971964871253345927816612548397897613425"
+};
+
+static const int BASE_GRID_COUNT = sizeof(BASE_GRIDS) / sizeof(BASE_GRIDS[0]);
+
+// Random full grid in constant time: every transform keeps a valid grid valid, so nothing is solved
+static Sudoku shuffledGrid(Random &random) {
+    STATS_ADD(gridAttempts, 1);
+    Sudoku base;
+    base.loadString(BASE_GRIDS[random.below(BASE_GRID_COUNT)]);
+    return applyTransform(base, randomTransform(random));
+}
+
+// Counted on the iterative search, whose singles propagation settles most of the
+// near-minimal boards asked about here without branching
+static bool hasUniqueSolution(const Sudoku &puzzle) {
+    static thread_local IterativeSearch<3> search;
+    SearchBudget unlimited = { 0, 0, NULL };
+    search.count(puzzle, 2, unlimited);
+    return search.getSolutions() == 1;
+}
+
+static bool hasUniqueSolution(VariantSudoku &puzzle) {
+    return puzzle.countSolutions(2) == 1;
+}
+
+// Replaces the solution with a fresh full grid, false when none was found
+static bool newGrid(Sudoku &solution, Random &random) {
+    solution = shuffledGrid(random);
+    return true;
+}
+
+static bool newGrid(VariantSudoku &solution, Random &random) {
+    VariantSudoku board(solution.getRules());
+    if(!board.solveRandom(random)) return false;
+
+    solution = board;
+    return true;
+}
+
+static void shuffleCells(int cells[81], Random &random) {
+    for(int i = 0; i < 81; i++) { cells[i] = i; }
+
+    for(int i = 80; i > 0; i--) {
+        int j = random.below(i + 1);
+        int tmp = cells[i];
+        cells[i] = cells[j];
+        cells[j] = tmp;
+    }
+}
+
+// Blanks clues in random order as long as the puzzle keeps a single solution and doesn't need
+// techniques above the level. Grading is only done once the cheaper count found the puzzle unique,
+// and stops as soon as the puzzle turns out too hard
+template <class Board>
+static void removeClues(Board &puzzle, int level, Random &random) {
+    int cells[81];
+    shuffleCells(cells, random);
+
+    for(int i = 0; i < 81; i++) {
+        int row = cells[i] / 9;
+        int col = cells[i] % 9;
+        int number = puzzle.getItem(row, col);
+        if(number == 0) continue;
+
+        puzzle.setItem(row, col, 0);
+        STATS_ADD(removalAttempts, 1);
+        if(!hasUniqueSolution(puzzle) || gradeSudoku(puzzle, level).level > level) {
+            puzzle.setItem(row, col, number);
+        } else {
+            STATS_ADD(removals, 1);
+        }
+    }
+}
+
+// How close a puzzle is to the next level: its level, and for Medium ones how often they needed
+// the Medium techniques (see HARD_MEDIUM_USES)
+static int getCloseness(const Grade &grade) {
+    if(grade.level != 1) return grade.level * CLOSENESS_PER_LEVEL;
+
+    int uses = grade.uses[LOCKED_CANDIDATES] + grade.uses[NAKED_PAIR] + grade.uses[HIDDEN_PAIR];
+    return CLOSENESS_PER_LEVEL + std::min(uses, CLOSENESS_PER_LEVEL - 1);
+}
+
+// Fills count random blank cells back in from the solution
+template <class Board>
+static void restoreClues(Board &puzzle, const Board &solution, int count, Random &random) {
+    int cells[81];
+    shuffleCells(cells, random);
+
+    for(int i = 0; i < 81 && count > 0; i++) {
+        int row = cells[i] / 9;
+        int col = cells[i] % 9;
+        if(puzzle.getItem(row, col) != 0) continue;
+
+        puzzle.setItem(row, col, solution.getItem(row, col));
+        count--;
+    }
+}
+
+/**
+ * Fills the solution with a fresh grid and blanks the puzzle from it down to the level.
+ * Removal keeps every level from getting too hard, but the result can still be easier than
+ * asked for (a Hard one may stop at pairs). Such a puzzle is reworked: some clues go back and
+ * blanking starts over from there, keeping the rework unless it got further from the level. A grid
+ * that doesn't get there after a while is swapped for a fresh one. With maxGrids 0 this goes on
+ * until the level is reached, otherwise it gives up (returning false) once that many grids failed.
+*/
+template <class Board>
+static bool makePuzzle(Board &solution, Board &puzzle, int level, int maxGrids, Random &random) {
+    if(!newGrid(solution, random)) return false;
+    puzzle = solution;
+    removeClues(puzzle, level, random);
+
+    int grids = 1;
+    int reached = getCloseness(gradeSudoku(puzzle));
+    int goal = level * CLOSENESS_PER_LEVEL;
+    for(int attempt = 1; reached < goal; attempt++) {
+        if(attempt % REWORK_ATTEMPTS == 0) {
+            if(grids == maxGrids || !newGrid(solution, random)) return false;
+            grids++;
+            puzzle = solution;
+            removeClues(puzzle, level, random);
+            reached = getCloseness(gradeSudoku(puzzle));
+            continue;
+        }
+
+        Board next = puzzle;
+        restoreClues(next, solution, RESTORED_CLUES, random);
+        removeClues(next, level, random);
+
+        int nextReached = getCloseness(gradeSudoku(next));
+        if(nextReached >= reached) {
+            puzzle = next;
+            reached = nextReached;
+        }
+    }
+
+    return true;
+}
+
+Puzzle generatePuzzle(int level, uint64_t seed) {
+    uint64_t id = makePuzzleId(level, seed);
+    Random random(id);
+
+    // Every classic level is reached sooner or later
+    Sudoku solution, puzzle;
+    makePuzzle(solution, puzzle, level, 0, random);
+    return Puzzle(id, solution, puzzle);
+}
+
+Puzzle regeneratePuzzle(uint64_t id) {
+    return generatePuzzle(getPuzzleLevel(id), id);
+}
+
+bool generateVariantPuzzle(const RuleTables &rules, int level, uint64_t seed, VariantSudoku &puzzle, VariantSudoku &solution) {
+    Random random(seed);
+    VariantSudoku board(rules), blanked(rules);
+
+    if(!makePuzzle(board, blanked, level, VARIANT_GRIDS, random)) return false;
+
+    solution = board;
+    puzzle = blanked;
+    return true;
+}
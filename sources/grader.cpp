@@ -0,0 +1,409 @@
+#include "../headers/grader.h"
+#include "../headers/stats.h"
+#include <cstring>
+
+/**
+ * --------------------- LOGICAL SOLVER ---------------------
+*/
+
+/**
+ * Works on the units of any rule set (see RuleTables). Rows are always units 0-8 and columns 9-17
+ * (parseRules adds them first), the fish need them. Hidden singles and subsets only look at units
+ * of 9 cells, a cage that holds fewer doesn't have to hold every number. Cages also narrow the
+ * candidates of their cells down to the numbers that can still make up their sum.
+*/
+class LogicalSolver {
+private:
+    const RuleTables &rules;
+    int value[81];
+    unsigned short cand[81];
+    int unsolved;
+    bool broken;        // Some cell ran out of candidates
+
+    void place(int cell, int number);
+    bool eliminate(int cell, unsigned short mask);
+    void narrowCage(int cage);
+    bool isInUnit(int cell, int unit);
+    unsigned short positions(int unit, int number);
+public:
+    LogicalSolver(const RuleTables &rules, const int values[81]);
+    bool isSolved() { return this->unsolved == 0; }
+    bool isBroken() { return this->broken; }
+    int nakedSingles();
+    int hiddenSingles();
+    bool lockedCandidates();
+    bool nakedSubset(int size);
+    bool hiddenSubset(int size);
+    bool fish(int size);
+};
+
+LogicalSolver::LogicalSolver(const RuleTables &rules, const int values[81]) : rules(rules) {
+    this->unsolved = 0;
+    this->broken = false;
+
+    for(int cell = 0; cell < 81; cell++) {
+        this->value[cell] = values[cell];
+        if(this->value[cell] == 0) this->unsolved++;
+    }
+
+    // Candidates are computed once every given is in place
+    for(int cell = 0; cell < 81; cell++) {
+        unsigned short used = 0;
+        for(int i = 0; i < rules.peerCount[cell]; i++) {
+            int number = this->value[rules.peers[cell][i]];
+            if(number > 0) used |= 1 << (number - 1);
+        }
+
+        if(this->value[cell] == 0) {
+            this->cand[cell] = ~used & 0x1FF;
+            if(this->cand[cell] == 0) this->broken = true;
+        } else {
+            this->cand[cell] = 0;
+            if(used & (1 << (this->value[cell] - 1))) this->broken = true;
+        }
+    }
+
+    for(int unit = 0; unit < rules.unitCount; unit++) {
+        if(rules.unitSum[unit] > 0) this->narrowCage(unit);
+    }
+}
+
+void LogicalSolver::place(int cell, int number) {
+    unsigned short bit = 1 << (number - 1);
+
+    this->value[cell] = number;
+    this->cand[cell] = 0;
+    this->unsolved--;
+
+    for(int i = 0; i < this->rules.peerCount[cell]; i++) {
+        int peer = this->rules.peers[cell][i];
+        if(this->value[peer] == 0 && (this->cand[peer] & bit)) {
+            this->cand[peer] &= ~bit;
+            if(this->cand[peer] == 0) this->broken = true;
+        }
+    }
+
+    for(int k = 0; k < this->rules.cellCageCount[cell]; k++) {
+        this->narrowCage(this->rules.cellCages[cell][k]);
+    }
+}
+
+// Removes the numbers in mask from the candidates of cell, returns true when something changed
+bool LogicalSolver::eliminate(int cell, unsigned short mask) {
+    if(this->value[cell] != 0 || (this->cand[cell] & mask) == 0) return false;
+
+    this->cand[cell] &= ~mask;
+    if(this->cand[cell] == 0) this->broken = true;
+    return true;
+}
+
+// Empty cells of a cage keep the numbers that still fit its sum
+void LogicalSolver::narrowCage(int cage) {
+    unsigned short used = 0;
+    int empty = 0, total = 0;
+
+    for(int k = 0; k < this->rules.unitSize[cage]; k++) {
+        int number = this->value[this->rules.unitCells[cage][k]];
+        if(number == 0) {
+            empty++;
+        } else {
+            used |= 1 << (number - 1);
+            total += number;
+        }
+    }
+
+    unsigned short fits = getCageCandidates(used, empty, this->rules.unitSum[cage] - total);
+    for(int k = 0; k < this->rules.unitSize[cage]; k++) {
+        this->eliminate(this->rules.unitCells[cage][k], ~fits & 0x1FF);
+    }
+}
+
+bool LogicalSolver::isInUnit(int cell, int unit) {
+    for(int k = 0; k < this->rules.unitSize[unit]; k++) {
+        if(this->rules.unitCells[unit][k] == cell) return true;
+    }
+    return false;
+}
+
+// Bit k is set when the k-th cell of the unit can hold number
+unsigned short LogicalSolver::positions(int unit, int number) {
+    unsigned short bit = 1 << (number - 1);
+    unsigned short result = 0;
+
+    for(int k = 0; k < this->rules.unitSize[unit]; k++) {
+        if(this->cand[this->rules.unitCells[unit][k]] & bit) result |= 1 << k;
+    }
+    return result;
+}
+
+int LogicalSolver::nakedSingles() {
+    int count = 0;
+
+    for(int cell = 0; cell < 81 && !this->broken; cell++) {
+        unsigned short c = this->cand[cell];
+        if(this->value[cell] == 0 && c != 0 && (c & (c - 1)) == 0) {
+            this->place(cell, __builtin_ctz(c) + 1);
+            count++;
+        }
+    }
+    return count;
+}
+
+int LogicalSolver::hiddenSingles() {
+    int count = 0;
+
+    for(int unit = 0; unit < this->rules.unitCount && !this->broken; unit++) {
+        if(this->rules.unitSize[unit] != 9) continue;
+
+        for(int number = 1; number <= 9; number++) {
+            unsigned short where = this->positions(unit, number);
+            if(where != 0 && (where & (where - 1)) == 0) {
+                this->place(this->rules.unitCells[unit][__builtin_ctz(where)], number);
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// A unit of 9 cells confines a number to cells that all share another unit (pointing and claiming
+// with the classic rules), so the number leaves the rest of that unit
+bool LogicalSolver::lockedCandidates() {
+    const RuleTables &rules = this->rules;
+    bool changed = false;
+
+    for(int unit = 0; unit < rules.unitCount; unit++) {
+        if(rules.unitSize[unit] != 9) continue;
+
+        for(int number = 1; number <= 9; number++) {
+            unsigned short where = this->positions(unit, number);
+            if(__builtin_popcount(where) < 2) continue;
+
+            // Every other unit of the first position, whether it holds the other positions as well
+            int first = rules.unitCells[unit][__builtin_ctz(where)];
+            int units = rules.cellUnitCount[first] + rules.cellCageCount[first];
+            for(int i = 0; i < units; i++) {
+                int shared = i < rules.cellUnitCount[first] ? rules.cellUnits[first][i] : rules.cellCages[first][i - rules.cellUnitCount[first]];
+                if(shared == unit) continue;
+
+                bool same = true;
+                for(int k = 0; k < 9 && same; k++) {
+                    if((where & (1 << k)) && !this->isInUnit(rules.unitCells[unit][k], shared)) same = false;
+                }
+                if(!same) continue;
+
+                for(int k = 0; k < rules.unitSize[shared]; k++) {
+                    int cell = rules.unitCells[shared][k];
+                    if(this->isInUnit(cell, unit)) continue;
+                    if(this->eliminate(cell, 1 << (number - 1))) changed = true;
+                }
+            }
+
+            if(changed) return true;
+        }
+    }
+    return false;
+}
+
+// size cells of a unit that share exactly size candidates: those numbers leave the rest of the unit
+bool LogicalSolver::nakedSubset(int size) {
+    const RuleTables &rules = this->rules;
+
+    for(int unit = 0; unit < rules.unitCount; unit++) {
+        int cells[9];
+        int count = 0;
+        for(int k = 0; k < rules.unitSize[unit]; k++) {
+            int cell = rules.unitCells[unit][k];
+            int candidates = __builtin_popcount(this->cand[cell]);
+            if(this->value[cell] == 0 && candidates >= 2 && candidates <= size) cells[count++] = cell;
+        }
+
+        // Every combination of size cells, as a bit mask over cells[]
+        for(int combo = 0; combo < (1 << count); combo++) {
+            if(__builtin_popcount(combo) != size) continue;
+
+            unsigned short mask = 0;
+            for(int i = 0; i < count; i++) {
+                if(combo & (1 << i)) mask |= this->cand[cells[i]];
+            }
+            if(__builtin_popcount(mask) != size) continue;
+
+            bool changed = false;
+            for(int k = 0; k < rules.unitSize[unit]; k++) {
+                int cell = rules.unitCells[unit][k];
+                bool inSubset = false;
+                for(int i = 0; i < count; i++) {
+                    if((combo & (1 << i)) && cells[i] == cell) inSubset = true;
+                }
+                if(!inSubset && this->eliminate(cell, mask)) changed = true;
+            }
+            if(changed) return true;
+        }
+    }
+    return false;
+}
+
+// size numbers confined to the same size cells of a unit: those cells lose every other candidate
+bool LogicalSolver::hiddenSubset(int size) {
+    for(int unit = 0; unit < this->rules.unitCount; unit++) {
+        if(this->rules.unitSize[unit] != 9) continue;
+
+        int numbers[9];
+        unsigned short where[9];
+        int count = 0;
+        for(int number = 1; number <= 9; number++) {
+            unsigned short mask = this->positions(unit, number);
+            int places = __builtin_popcount(mask);
+            if(places >= 2 && places <= size) {
+                numbers[count] = number;
+                where[count++] = mask;
+            }
+        }
+
+        for(int combo = 0; combo < (1 << count); combo++) {
+            if(__builtin_popcount(combo) != size) continue;
+
+            unsigned short cellsMask = 0;
+            unsigned short keep = 0;
+            for(int i = 0; i < count; i++) {
+                if(combo & (1 << i)) {
+                    cellsMask |= where[i];
+                    keep |= 1 << (numbers[i] - 1);
+                }
+            }
+            if(__builtin_popcount(cellsMask) != size) continue;
+
+            bool changed = false;
+            for(int k = 0; k < 9; k++) {
+                if((cellsMask & (1 << k)) && this->eliminate(this->rules.unitCells[unit][k], ~keep & 0x1FF)) changed = true;
+            }
+            if(changed) return true;
+        }
+    }
+    return false;
+}
+
+// X-Wing (size 2) and Swordfish (size 3): a number confined to the same size columns in size rows
+// leaves those columns everywhere else (and the same with rows and columns swapped)
+bool LogicalSolver::fish(int size) {
+    for(int number = 1; number <= 9; number++) {
+        // base 0: rows define the fish and columns lose the number, base 1 the other way round
+        for(int base = 0; base < 2; base++) {
+            int lines[9];
+            unsigned short where[9];
+            int count = 0;
+            for(int i = 0; i < 9; i++) {
+                unsigned short mask = this->positions(base * 9 + i, number);
+                int places = __builtin_popcount(mask);
+                if(places >= 2 && places <= size) {
+                    lines[count] = i;
+                    where[count++] = mask;
+                }
+            }
+
+            for(int combo = 0; combo < (1 << count); combo++) {
+                if(__builtin_popcount(combo) != size) continue;
+
+                unsigned short cover = 0;
+                unsigned short fishLines = 0;
+                for(int i = 0; i < count; i++) {
+                    if(combo & (1 << i)) {
+                        cover |= where[i];
+                        fishLines |= 1 << lines[i];
+                    }
+                }
+                if(__builtin_popcount(cover) != size) continue;
+
+                bool changed = false;
+                for(int k = 0; k < 9; k++) {
+                    if(!(cover & (1 << k))) continue;
+                    for(int i = 0; i < 9; i++) {
+                        if(fishLines & (1 << i)) continue;
+                        int cell = base == 0 ? i * 9 + k : k * 9 + i;
+                        if(this->eliminate(cell, 1 << (number - 1))) changed = true;
+                    }
+                }
+                if(changed) return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * --------------------- GRADING ---------------------
+*/
+
+const char* getTechniqueName(int technique) {
+    static const char *names[TECHNIQUE_COUNT] = {
+        "Naked single", "Hidden single", "Locked candidates", "Naked pair", "Hidden pair",
+        "Naked triple", "Hidden triple", "X-Wing", "Swordfish"
+    };
+    return technique >= 0 && technique < TECHNIQUE_COUNT ? names[technique] : "None";
+}
+
+// Level of a technique on its own
+static int getTechniqueLevel(int technique) {
+    if(technique <= HIDDEN_SINGLE) return 0;
+    return technique <= HIDDEN_PAIR ? 1 : 2;
+}
+
+static Grade gradeBoard(const RuleTables &rules, const int values[81], int maxLevel) {
+    STATS_ADD(grades, 1);
+
+    Grade grade;
+    grade.level = 0;
+    grade.hardest = -1;
+    memset(grade.uses, 0, sizeof(grade.uses));
+    int mediumUses = 0;
+
+    LogicalSolver solver(rules, values);
+
+    while(!solver.isSolved() && !solver.isBroken()) {
+        int technique = -1;
+        int count;
+
+        if((count = solver.nakedSingles()) > 0) {
+            technique = NAKED_SINGLE;
+        } else if((count = solver.hiddenSingles()) > 0) {
+            technique = HIDDEN_SINGLE;
+        } else {
+            count = 1;
+            if(solver.lockedCandidates()) technique = LOCKED_CANDIDATES;
+            else if(solver.nakedSubset(2)) technique = NAKED_PAIR;
+            else if(solver.hiddenSubset(2)) technique = HIDDEN_PAIR;
+            else if(solver.nakedSubset(3)) technique = NAKED_TRIPLE;
+            else if(solver.hiddenSubset(3)) technique = HIDDEN_TRIPLE;
+            else if(solver.fish(2)) technique = X_WING;
+            else if(solver.fish(3)) technique = SWORDFISH;
+        }
+
+        if(technique < 0) break;    // Stuck, the puzzle needs guessing or harder techniques
+
+        grade.uses[technique] += count;
+        if(technique > grade.hardest) grade.hardest = technique;
+
+        int level = getTechniqueLevel(technique);
+        if(level == 1) mediumUses++;
+        if(level == 1 && mediumUses >= HARD_MEDIUM_USES) level = 2;
+        if(level > grade.level) grade.level = level;
+        if(grade.level > maxLevel) break;
+    }
+
+    grade.solved = solver.isSolved() && !solver.isBroken();
+    if(!grade.solved && grade.level <= maxLevel) grade.level = 3;
+
+    return grade;
+}
+
+Grade gradeSudoku(Sudoku &sudoku, int maxLevel) {
+    int values[81];
+    for(int cell = 0; cell < 81; cell++) values[cell] = sudoku.getItem(cell / 9, cell % 9);
+    return gradeBoard(getClassicRules(), values, maxLevel);
+}
+
+Grade gradeSudoku(VariantSudoku &sudoku, int maxLevel) {
+    int values[81];
+    for(int cell = 0; cell < 81; cell++) values[cell] = sudoku.getItem(cell / 9, cell % 9);
+    return gradeBoard(sudoku.getRules(), values, maxLevel);
+}
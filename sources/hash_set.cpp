@@ -0,0 +1,61 @@
+#include "../headers/hash_set.h"
+
+HashSet::HashSet(int slotBits) {
+    this->slots.assign((size_t) 1 << slotBits, 0);
+    this->mask = this->slots.size() - 1;
+    this->count = 0;
+}
+
+void HashSet::grow() {
+    std::vector <uint64_t> old;
+    old.swap(this->slots);
+    this->slots.assign(old.size() * 2, 0);
+    this->mask = this->slots.size() - 1;
+    this->count = 0;
+    for(size_t i = 0; i < old.size(); i++) {
+        if(old[i] != 0) this->insert(old[i]);
+    }
+}
+
+bool HashSet::insert(uint64_t hash) {
+    if(hash == 0) hash = 1;     // 0 marks an empty slot
+    if((uint64_t) (this->count + 1) * 2 > this->slots.size()) this->grow();
+
+    for(uint64_t i = hash & this->mask; ; i = (i + 1) & this->mask) {
+        if(this->slots[i] == hash) return false;
+        if(this->slots[i] == 0) {
+            this->slots[i] = hash;
+            this->count++;
+            return true;
+        }
+    }
+}
+
+long HashSet::size() const {
+    return this->count;
+}
+
+bool HashSet::load(FILE *file) {
+    uint64_t hashes[4096];
+    size_t count;
+    while((count = fread(hashes, sizeof(uint64_t), 4096, file)) > 0) {
+        for(size_t i = 0; i < count; i++) {
+            this->insert(hashes[i]);
+        }
+    }
+    return !ferror(file);
+}
+
+bool HashSet::save(FILE *file) const {
+    for(size_t i = 0; i < this->slots.size(); i++) {
+        if(this->slots[i] != 0 && fwrite(&this->slots[i], sizeof(uint64_t), 1, file) != 1) return false;
+    }
+    return true;
+}
+
+bool ShardedHashSet::insert(uint64_t hash) {
+    // The low bits pick the slot within a shard
+    Shard &shard = this->shards[hash >> (64 - SHARD_BITS)];
+    std::unique_lock<std::mutex> guard(shard.lock);
+    return shard.hashes.insert(hash);
+}
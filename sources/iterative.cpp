@@ -0,0 +1,145 @@
+#include "../headers/iterative.h"
+#include "../headers/propagate.h"
+#include "../headers/stats.h"
+#include <chrono>
+
+// Singles are filled before searching, the vectorized propagation only exists for 9x9
+static int propagate(BasicSudoku<3> &sudoku) {
+    return propagateSingles(sudoku);
+}
+
+template <int BoxN>
+static int propagate(BasicSudoku<BoxN> &) {
+    return 0;
+}
+
+template <int BoxN>
+void IterativeSearch<BoxN>::place(int cell, int number) {
+    this->work.placeNumber(cell / Board::SIZE, cell % Board::SIZE, number);
+    this->trail[this->trailHeight++] = cell;
+    this->nodes++;
+    STATS_ADD(nodes, 1);
+}
+
+template <int BoxN>
+void IterativeSearch<BoxN>::undoTo(int height) {
+    while(this->trailHeight > height) {
+        int cell = this->trail[--this->trailHeight];
+        this->work.removeNumber(cell / Board::SIZE, cell % Board::SIZE);
+    }
+}
+
+template <int BoxN>
+SearchResult IterativeSearch<BoxN>::run(const Board &board, const SearchBudget &budget, int limit, std::atomic<int> *shared) {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(budget.ms));
+
+    this->work = board;
+    this->trailHeight = 0;
+    this->nodes = 0;
+    this->solutions = 0;
+
+    // Conflicting givens would otherwise make the search exhaust the whole tree
+    if(!this->work.isValid()) return SEARCH_UNSOLVABLE;
+    if(budget.cancel != NULL && budget.cancel->isCancelled()) return SEARCH_CANCELLED;
+
+    int filled = propagate(this->work);
+    if(filled < 0) return SEARCH_UNSOLVABLE;
+    STATS_ADD(propagated, filled);
+
+    int depth = 0;      // Choice points on the stack
+    while(1) {
+        int row, col;
+        Mask candidates;
+        int found = this->work.findConstrainedCell(row, col, candidates);
+
+        if(found == 0) {
+            // The work board holds the solution until the search moves on
+            this->solutions++;
+            bool reached = shared != NULL ? shared->fetch_add(1) + 1 >= limit : this->solutions >= limit;
+            if(reached) return SEARCH_SOLVED;
+        }
+
+        if(found > 0 && (candidates & (candidates - 1)) == 0) {
+            // Forced cell, only the trail has to know about it
+            this->place(row * Board::SIZE + col, __builtin_ctz(candidates) + 1);
+        } else {
+            if(found > 0) {
+                Choice &choice = this->stack[depth++];
+                choice.cell = row * Board::SIZE + col;
+                choice.trailHeight = this->trailHeight;
+                choice.candidates = candidates;
+                STATS_MAX(maxDepth, depth);
+            } else {
+                STATS_ADD(backtracks, 1);
+            }
+
+            // Next number of the innermost choice point that has one left
+            while(depth > 0 && this->stack[depth - 1].candidates == 0) depth--;
+            if(depth == 0) return this->solutions > 0 ? SEARCH_SOLVED : SEARCH_UNSOLVABLE;
+
+            Choice &choice = this->stack[depth - 1];
+            this->undoTo(choice.trailHeight);
+            int number = __builtin_ctz(choice.candidates) + 1;
+            choice.candidates &= choice.candidates - 1;
+            this->place(choice.cell, number);
+        }
+
+        if(budget.nodes > 0 && this->nodes >= budget.nodes) return SEARCH_BUDGET;
+        if(this->nodes % CHECK_INTERVAL == 0) {
+            if(budget.cancel != NULL && budget.cancel->isCancelled()) return SEARCH_CANCELLED;
+            if(budget.ms > 0 && std::chrono::steady_clock::now() >= deadline) return SEARCH_BUDGET;
+        }
+    }
+}
+
+template <int BoxN>
+SearchResult IterativeSearch<BoxN>::solve(Board &board, const SearchBudget &budget) {
+    SearchResult result = this->run(board, budget, 1, NULL);
+    if(result == SEARCH_SOLVED) board = this->work;
+    return result;
+}
+
+template <int BoxN>
+SearchResult IterativeSearch<BoxN>::count(const Board &board, int limit, const SearchBudget &budget, std::atomic<int> *shared) {
+    SearchResult result = this->run(board, budget, limit, shared);
+    return result == SEARCH_UNSOLVABLE ? SEARCH_SOLVED : result;
+}
+
+template <int BoxN>
+int IterativeSearch<BoxN>::getSolutions() {
+    return this->solutions;
+}
+
+template <int BoxN>
+long IterativeSearch<BoxN>::getNodes() {
+    return this->nodes;
+}
+
+template class IterativeSearch<2>;
+template class IterativeSearch<3>;
+template class IterativeSearch<4>;
+template class IterativeSearch<5>;
+
+const char* IterativeSolver::getName() {
+    return "iterative";
+}
+
+bool IterativeSolver::solve(Sudoku &sudoku) {
+    SearchBudget unlimited = { 0, 0, NULL };
+    return this->search.solve(sudoku, unlimited) == SEARCH_SOLVED;
+}
+
+SearchResult IterativeSolver::solveBounded(Sudoku &sudoku, const SearchBudget &budget) {
+    return this->search.solve(sudoku, budget);
+}
+
+SearchResult IterativeSolver::countBounded(Sudoku &sudoku, int limit, int &solutions, const SearchBudget &budget) {
+    SearchResult result = this->search.count(sudoku, limit, budget);
+    solutions = this->search.getSolutions();
+    return result;
+}
+
+bool IterativeSolver::isBounded() {
+    return true;
+}
@@ -0,0 +1,95 @@
+#include "../headers/line_pipeline.h"
+#include "../headers/thread_pool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
+
+static const int CHUNK_LINES = 4096;            // Lines handed to a worker at once
+static const size_t IO_BLOCK = 1 << 20;         // Size of the buffered reads and writes
+
+double LineRun::getRate(long count) const {
+    return this->seconds > 0 ? count / this->seconds : 0.0;
+}
+
+bool runLinePipeline(const std::string &path, int threads, const std::function<LineChunk*()> &create,
+    const std::function<void(LineChunk*)> &work, const std::function<void(LineChunk*)> &done, LineRun &run) {
+    FILE *input = path == "-" ? stdin : fopen(path.c_str(), "rb");
+    if(input == NULL) {
+        fprintf(stderr, "Can't open %s\n", path.c_str());
+        return false;
+    }
+
+    setvbuf(stdout, NULL, _IOFBF, IO_BLOCK);
+
+    ThreadPool pool(threads);
+    size_t maxPending = pool.getSize() * 4;     // Bounds the memory held by chunks in flight
+    std::deque <LineChunk*> pending;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    auto flushOldest = [&]() {
+        LineChunk *chunk = pending.front();
+        pending.pop_front();
+
+        chunk->done.wait();
+        done(chunk);
+        delete chunk;
+    };
+
+    auto dispatch = [&](LineChunk *chunk) {
+        std::shared_ptr<std::packaged_task<void()> > task(
+            new std::packaged_task<void()>(std::bind(work, chunk)));
+        chunk->done = task->get_future();
+        pool.submit([task]() { (*task)(); });
+
+        pending.push_back(chunk);
+        if(pending.size() >= maxPending) flushOldest();
+    };
+
+    std::vector <char> block(IO_BLOCK);
+    LineChunk *current = create();
+    int lines = 0;
+    size_t count;
+
+    while((count = fread(&block[0], 1, IO_BLOCK, input)) > 0) {
+        const char *segment = &block[0];    // Start of the data not yet added to a chunk
+        const char *cursor = segment;
+        const char *end = segment + count;
+        const char *newline;
+
+        while((newline = (const char*) memchr(cursor, '\n', end - cursor)) != NULL) {
+            cursor = newline + 1;
+
+            if(++lines == CHUNK_LINES) {
+                current->input.append(segment, cursor - segment);
+                dispatch(current);
+                current = create();
+                lines = 0;
+                segment = cursor;
+            }
+        }
+
+        // Partial last line continues in the next block
+        current->input.append(segment, end - segment);
+    }
+
+    if(!current->input.empty()) {
+        dispatch(current);
+    } else {
+        delete current;
+    }
+
+    while(!pending.empty()) {
+        flushOldest();
+    }
+    fflush(stdout);
+
+    if(input != stdin) fclose(input);
+
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.threads = pool.getSize();
+    return true;
+}
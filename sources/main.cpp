@@ -3,6 +3,20 @@
 #include <unistd.h>
 #include <string>
 #include "../headers/sudoku.h"
+#include "../headers/solver.h"
+#include "../headers/batch.h"
+#include "../headers/bulk.h"
+#include "../headers/bank.h"
+#include "../headers/puzzle_queue.h"
+#include "../headers/renderer.h"
+#include "../headers/game_state.h"
+#include "../headers/server.h"
+#include "../headers/dedup.h"
+#include "../headers/session.h"
+#include "../headers/verify.h"
+#include "../headers/rules.h"
+#include <cerrno>
+#include <cstdlib>
 
 using namespace std;
 
@@ -13,41 +27,44 @@ float WIN_RATE = 0;
 int gameMode = 0;
 int maxHeight;
 int maxWidth;
-int mistakes = -1;
+bool animateBoard = false;  // Uncover a new board line by line (--animate)
 
-Sudoku *sudoku_to_check;    // Sudoku array that is correctly and fully filled with numbers
-Sudoku *sudoku_to_fill;     // Sudoku that stores empty fields
-Sudoku *sudoku_to_play;     // Sudoku that the player can modify
+PuzzleQueue *puzzles = NULL; // Puzzles generated in the background, ready to be played
+PuzzleBank *bank = NULL;    // Pre-generated puzzles (--bank FILE), used instead of the queue
 
 /**
- * --------------------------- SUDOKU CHECK ---------------------------
+ * --------------------------- INIT NCURSES FUNCTIONS ---------------------------
 */
+SCREEN *replayScreen = NULL;    // Virtual terminal of a replay
+FILE *replayOutput = NULL;      // And the /dev/null it writes to
 
-bool sudokuCheck() {
-    for(int i = 0; i < 9; i++) {
-        for(int j = 0; j < 9; j++) {
-            if(sudoku_to_play->getItem(i, j) != sudoku_to_check->getItem(i, j)) {
-                move(0,0);
-                printw("Not yet filled up");
-                refresh();
-                return false;   // Keep playing
-            }
+void start_ncurses() {
+    if(isReplaying()) {
+        // Virtual terminal for a replay, it gets the recorded size from LINES and COLUMNS
+        replayOutput = fopen("/dev/null", "r+");
+        if(replayOutput == NULL) {
+            fprintf(stderr, "Can't open /dev/null\n");
+            exit(1);
         }
+        const char *term = getenv("TERM");
+        replayScreen = newterm(term, replayOutput, replayOutput);
+        if(replayScreen == NULL) replayScreen = newterm("xterm", replayOutput, replayOutput);
+    } else {
+        initscr();
     }
-
-    return true;    // Sudoku filled up correctly
-}
-
-/**
- * --------------------------- INIT NCURSES FUNCTIONS ---------------------------
-*/
-void start_ncurses() {
-    initscr();
     noecho();
     raw();
     curs_set(0);    // cursor visibility
 }
 
+void stop_ncurses() {
+    endwin();
+    if(replayScreen != NULL) delscreen(replayScreen);
+    if(replayOutput != NULL) fclose(replayOutput);
+    replayScreen = NULL;
+    replayOutput = NULL;
+}
+
 // Terminal info
 void getTerminalInfo() {
     getmaxyx(stdscr, maxHeight, maxWidth);
@@ -99,45 +116,37 @@ void toolTipMessage(string message, string message1) {
 }
 
 /**
- * --------------------------- WINDOWS HELPER FUNCTIONS ---------------------------
+ * --------------------------- SCREENS ---------------------------
+ * The whole game is one event loop: every key goes to the handler of the current screen, which
+ * returns the screen to continue with. enterScreen() draws what a screen needs when it is
+ * switched to. The windows, the board view and the game are created once and reused, so
+ * playing any number of games takes the same memory and stack.
 */
+enum Screen {
+    MAIN_MENU,      // New game / Game mode
+    MODE_MENU,      // Easy / Medium / Hard submenu
+    EXIT_PROMPT,    // Asks before leaving, goes back to promptReturn otherwise
+    GAME,
+    ALERT,          // End of a game, any key goes back to the main menu
+    QUIT
+};
 
-void alertScreen();
-void mainScreen(int height, int width, int start_y, int start_x);
-void gameMenuWindow(WINDOW* window, int highlighted);   // WINDOW_CODE: 0
-void gameModeWindow(WINDOW* window);    // WINDOW_CODE: 1
+WINDOW *menu_window = NULL;
+WINDOW *stats_window = NULL;
+WINDOW *sudoku_window = NULL;
+BoardView *view = NULL;
+GameState game = GameState(Sudoku(), Sudoku());
 
-void clearView() {
-    for(int i = 0; i < maxWidth; i++) {
-        for(int j = 0; j < maxHeight; j++) {
-            move(j, i);
-            printw(" ");
-            refresh();
-        }
-    }
-}
+int menuHighlighted = 0;
+int modeHighlighted = 0;
+Screen promptReturn = MAIN_MENU;
+const char *alertMessage = "";
+int selectedX = 0;
+int selectedY = 0;
 
-void alertScreen(const char* message) {
-    clearView();
-    move(maxHeight / 2, 10);
-    printw(message);
-    move((maxHeight / 2) + 1, 10);
-    printw("Press any key to go back to main menu");
-
-    int height, width, start_y, start_x;
-    height = 9;
-    width = 50;
-    start_y = 5;
-    start_x = 10;
-
-    while(1) {
-        char c = getch();
-        if(c) {
-            clearView();
-            mainScreen(height, width, start_y, start_x);
-            break;
-        }
-    }
+void clearView() {
+    erase();
+    refresh();
 }
 
 void printGameMode() {
@@ -183,46 +192,6 @@ void statsWindow(WINDOW* window) {
     wrefresh(window);
 }
 
-void exitPrompt(WINDOW* window, int highlighted, int returnWindow) {
-    keypad(stdscr, true);
-    
-    int c;
-
-    curs_set(1);
-    echo();
-    mvwprintw(stdscr, maxHeight - 2, 18, "Do you really want to leave? [y/n]");
-
-    c = wgetch(stdscr);
-
-    if(c == 121 || c == 89) {
-        // y || Y
-        return;
-    } else {
-        // Any other key
-        mvwprintw(stdscr, maxHeight - 2, 18, "                                      ");
-        refresh();
-        keypad(stdscr, false);
-        curs_set(0);
-        noecho();
-        if(returnWindow == 0) {
-            gameMenuWindow(window, highlighted);
-        }
-        if(returnWindow == 1) {
-            gameModeWindow(window);
-        }
-    }
-}
-
-// Columns
-int coordinatesX[9] = {
-    3, 6, 9,  15, 18, 21,  27, 30, 33
-};
-
-// Lines
-int coordinatesY[9] = {
-    1, 3, 5,  7, 9, 11,  13, 15, 17
-};
-
 void controlsInfo() {
     move(maxHeight - 2, maxWidth - 40);
     printw("Use ");
@@ -230,375 +199,690 @@ void controlsInfo() {
     printw("WASD");
     attroff(A_UNDERLINE);
     printw(" buttons to navigate the board.");
+    move(maxHeight - 3, maxWidth - 40);
+    printw("Press U to undo, R to redo a move.");
 }
 
-void addMistake() {
+void printMistakes(int mistakes) {
     move(3, 1);
     printw("Mistakes: %d", mistakes);
-    refresh();
+    wnoutrefresh(stdscr);
 }
 
-void renderSudoku(WINDOW *window, Sudoku *sudoku, int selectedX, int selectedY) {
-
-    mvwhline(window, 6, 1, ACS_HLINE, 35);
-    mvwhline(window, 12, 1, ACS_HLINE, 35);
-    mvwvline(window, 1, 12, ACS_VLINE, 17);
-    mvwvline(window, 1, 24, ACS_VLINE, 17);
-
-    for(int i = 0; i < 9; i++) {
-        for(int j = 0; j < 9; j++) {
-            if(sudoku->getItem(j, i) == 0) {
-                if(selectedX == i && selectedY == j) {
-                    wattron(window, A_UNDERLINE);
-                    mvwprintw(window, coordinatesY[i], coordinatesX[j], "*");
-                    wattroff(window, A_UNDERLINE);
-                } else {
-                    wattron(window, A_UNDERLINE);
-                    mvwprintw(window, coordinatesY[i], coordinatesX[j], " ");
-                    wattroff(window, A_UNDERLINE);
-                    wrefresh(window);
-                }
+// Sets every cell of the view from the game, the view only redraws the ones that changed
+void updateBoard(BoardView &view, GameState &game, int selectedX, int selectedY) {
+    for(int x = 0; x < 9; x++) {
+        for(int y = 0; y < 9; y++) {
+            int number = game.getItem(x, y);
+            bool selected = x == selectedX && y == selectedY;
+
+            if(number == 0) {
+                view.setCell(x, y, 0, selected ? BoardView::CURSOR : BoardView::BLANK);
+            } else if(game.isWrong(x, y)) {
+                view.setCell(x, y, number, BoardView::WRONG);
+            } else if(game.isConflict(x, y)) {
+                // A given or correct number that a wrong one repeats
+                view.setCell(x, y, number, BoardView::CONFLICT);
             } else {
-                mvwprintw(window, coordinatesY[i], coordinatesX[j], "%d", sudoku->getItem(j, i));
-                wrefresh(window);
+                view.setCell(x, y, number, selected ? BoardView::SELECTED : BoardView::NUMBER);
             }
-            usleep(10000);
         }
     }
 }
 
-void setNumber(WINDOW *window, int selectedX, int selectedY, char number) {
-    if(sudoku_to_fill->getItem(selectedX, selectedY) == 0) {
-        sudoku_to_play->setItem(selectedX, selectedY, number - '0');
-        mvwprintw(window, coordinatesY[selectedY], coordinatesX[selectedX], "%d", sudoku_to_play->getItem(selectedX, selectedY));
+void drawBoard() {
+    updateBoard(*view, game, selectedX, selectedY);
+    view->draw();
+    endFrame();
+}
+
+void drawMainMenu() {
+    string choices[2] = {"New game", "Game mode"};
+
+    for(int i = 0; i < 2; i++) {
+        if(i == menuHighlighted) {
+            highlightText(menu_window, 2 * (i + 1) + 1, 5, choices[i].c_str());
+
+            if(i == 0) {
+                toolTipMessage("Press ENTER to start a new game.", "");
+            } else {
+                toolTipMessage("Press RIGHT_ARROW or ENTER to open submenu.", "");
+            }
+        } else {
+            mvwprintw(menu_window, 2 * (i + 1) + 1, 5, choices[i].c_str());
+        }
     }
 }
 
-void startGame() {
-    GAMES_STARTED += 1;
-    mistakes = -1;
+void drawModeMenu() {
+    string modes[3] = {"Easy", "Medium", "Hard"};
+
+    for(int i = 0; i < 3; i++) {
+        if(i == modeHighlighted) {
+            highlightText(menu_window, 2 * (i + 1), 28, modes[i].c_str());
+        } else {
+            mvwprintw(menu_window, 2 * (i + 1), 28, modes[i].c_str());
+        }
+    }
+}
 
-    int height, width, start_y, start_x;
-    height = 19;
-    width = 37;
-    start_y = 5;
-    start_x = 10;
+void createWindows() {
+    menu_window = newwin(9, 50, 5, 10);
+    stats_window = newwin(9, 50, 5, 70);
+    sudoku_window = newwin(19, 37, 5, 10);
+    view = new BoardView(sudoku_window);
 
-    int selectedX, selectedY;
+    keypad(menu_window, true);   // So we can use arrow keys
+    box(menu_window, 0, 0);
+    box(stats_window, 0, 0);
+    mvwprintw(menu_window, 0, 2, " Sudoku puzzle main menu ");
+}
+
+void deleteWindows() {
+    delete view;
+    delwin(sudoku_window);
+    delwin(stats_window);
+    delwin(menu_window);
+}
+
+// Takes the next puzzle and shows the board and everything around it
+void enterGame() {
+    GAMES_STARTED += 1;
     selectedX = 0;
     selectedY = 0;
 
-    char choice = '0';
-
     clearView();
 
     printGameMode();
     getTerminalInfo();
-    refresh();
 
     controlsInfo();
-    mistakes += 1;
-    addMistake();
+    printMistakes(0);
 
-    WINDOW *sudoku_window = newwin(height, width, start_y, start_x);
-    box(sudoku_window, 0, 0);
-    wrefresh(sudoku_window);
-
-    sudoku_to_check = new Sudoku();
-    sudoku_to_check->solveSudoku(0, 0);
+    Puzzle puzzle(0, Sudoku(), Sudoku());
+    if(isReplaying()) {
+        puzzle = replayPuzzle();
+    } else {
+        // A damaged bank doesn't end the game, the puzzle is generated instead
+        if(bank == NULL) {
+            puzzle = puzzles->take(gameMode);
+        } else if(!bank->getRandomPuzzle(gameMode, puzzle)) {
+            puzzle = generatePuzzle(gameMode, randomSeed());
+        }
+        recordPuzzle(puzzle);
+    }
 
-    sudoku_to_fill = sudoku_to_check->copySudoku();
-    sudoku_to_fill->generateSudoku(gameMode);
+    game.reset(puzzle.puzzle, puzzle.solution);
 
-    sudoku_to_play = sudoku_to_fill->copySudoku();
+    if(puzzle.id != 0) {
+        move(4, 1);
+        printw("Puzzle ID: %016llx", (unsigned long long) puzzle.id);
+    }
 
     info();
+    wnoutrefresh(stdscr);
 
-    refresh();
+    // The screen was cleared, so the board is drawn again in full
+    view->invalidate();
+    touchwin(sudoku_window);
 
-    renderSudoku(sudoku_window, sudoku_to_play, selectedX, selectedY);
+    if(animateBoard) {
+        // Ticks come from the input timeout, so keys keep working while the board is uncovered
+        view->startReveal();
+        wtimeout(sudoku_window, 15);
+    } else {
+        wtimeout(sudoku_window, -1);
+    }
 
-    while(1) {
-        if(sudoku_to_play->getItem(selectedX, selectedY) == 0) {
-            wattron(sudoku_window, A_UNDERLINE);
-            mvwprintw(sudoku_window, coordinatesY[selectedY], coordinatesX[selectedX], "*");
-            wattroff(sudoku_window, A_UNDERLINE);
-            wrefresh(sudoku_window);
-        } else {
-            if(sudoku_to_play->getItem(selectedX, selectedY) != 0 && sudoku_to_play->getItem(selectedX, selectedY) == sudoku_to_check->getItem(selectedX, selectedY)) {
-                wattron(sudoku_window, A_BOLD);
-                mvwprintw(sudoku_window, coordinatesY[selectedY], coordinatesX[selectedX], "%d", sudoku_to_play->getItem(selectedX, selectedY));
-                wattroff(sudoku_window, A_BOLD);
-            } else {
-                mistakes += 1;
-                addMistake();
-                if(mistakes >= 3) {
-                    alertScreen("Game over...");
-                    break;
-                }
-                wattron(sudoku_window, COLOR_PAIR(4));
-                wattron(sudoku_window, A_BOLD);
-                mvwprintw(sudoku_window, coordinatesY[selectedY], coordinatesX[selectedX], "%d", sudoku_to_play->getItem(selectedX, selectedY));
-                wattroff(sudoku_window, COLOR_PAIR(4));
-                wattroff(sudoku_window, A_BOLD);
-            }
-            wrefresh(sudoku_window);
-        }
+    drawBoard();
+}
 
-        choice = wgetch(sudoku_window);
-
-        if(choice == 'w') {
-            if(selectedY > 0) {
-                selectedY--;
-                if(sudoku_to_play->getItem(selectedX, selectedY + 1) != 0) {
-                    if(sudoku_to_play->getItem(selectedX, selectedY + 1) == sudoku_to_check->getItem(selectedX, selectedY + 1)) {
-                        mvwprintw(sudoku_window, coordinatesY[selectedY + 1], coordinatesX[selectedX], "%d", sudoku_to_play->getItem(selectedX, selectedY + 1));
-                        wrefresh(sudoku_window);
-                    }
-                } else {
-                    wattron(sudoku_window, A_UNDERLINE);
-                    mvwprintw(sudoku_window, coordinatesY[selectedY + 1], coordinatesX[selectedX], " ");
-                    wattroff(sudoku_window, A_UNDERLINE);
-                    wrefresh(sudoku_window);
-                }
+// Draws a screen that is switched to from previous (QUIT when nothing was shown yet)
+void enterScreen(Screen screen, Screen previous) {
+    switch(screen) {
+        case MAIN_MENU:
+            if(previous == ALERT || previous == QUIT) {
+                // The screen is empty, the kept windows only have to be shown again
+                getTerminalInfo();
+                info();
+                touchwin(menu_window);
+                touchwin(stats_window);
+                statsWindow(stats_window);
             }
-        }
+            printGameMode();
+            drawMainMenu();
+            break;
 
-        if(choice == 's') {
-            if(selectedY < 8) {
-                selectedY++;
-                if(sudoku_to_play->getItem(selectedX, selectedY - 1) != 0) {
-                    if(sudoku_to_play->getItem(selectedX, selectedY - 1) == sudoku_to_check->getItem(selectedX, selectedY - 1)) {
-                        mvwprintw(sudoku_window, coordinatesY[selectedY - 1], coordinatesX[selectedX], "%d", sudoku_to_play->getItem(selectedX, selectedY - 1));
-                        wrefresh(sudoku_window);
-                    }
-                } else {
-                    wattron(sudoku_window, A_UNDERLINE);
-                    mvwprintw(sudoku_window, coordinatesY[selectedY - 1], coordinatesX[selectedX], " ");
-                    wattroff(sudoku_window, A_UNDERLINE);
-                    wrefresh(sudoku_window);
-                }
-            }
-        }
+        case MODE_MENU:
+            modeHighlighted = gameMode;
+            wattron(menu_window, A_BOLD);
+            wattron(menu_window, A_UNDERLINE);
+            mvwprintw(menu_window, 5, 5, "Game mode");
+            wattroff(menu_window, A_BOLD);
+            wattroff(menu_window, A_UNDERLINE);
 
-        if(choice == 'a') {
-            if(selectedX > 0) {
-                selectedX--;
-                if(sudoku_to_play->getItem(selectedX + 1, selectedY) != 0) {
-                    if(sudoku_to_play->getItem(selectedX + 1, selectedY) == sudoku_to_check->getItem(selectedX + 1, selectedY)) {
-                        mvwprintw(sudoku_window, coordinatesY[selectedY], coordinatesX[selectedX + 1], "%d", sudoku_to_play->getItem(selectedX + 1, selectedY));
-                        wrefresh(sudoku_window);
-                    }
-                } else {
-                    wattron(sudoku_window, A_UNDERLINE);
-                    mvwprintw(sudoku_window, coordinatesY[selectedY], coordinatesX[selectedX + 1], " ");
-                    wattroff(sudoku_window, A_UNDERLINE);
-                    wrefresh(sudoku_window);
-                }
-            }
-        }
+            toolTipMessage("Select an option with ENTER", "Press LEFT_ARROW to close the submenu");
+            drawModeMenu();
+            break;
 
-        if(choice == 'd') {
-            if(selectedX < 8) {
-                selectedX++;
-                if(sudoku_to_play->getItem(selectedX - 1, selectedY) != 0) {
-                    if(sudoku_to_play->getItem(selectedX - 1, selectedY) == sudoku_to_check->getItem(selectedX - 1, selectedY)) {
-                        mvwprintw(sudoku_window, coordinatesY[selectedY], coordinatesX[selectedX - 1], "%d", sudoku_to_play->getItem(selectedX - 1, selectedY));
-                        wrefresh(sudoku_window);
-                    }
-                } else {
-                    wattron(sudoku_window, A_UNDERLINE);
-                    mvwprintw(sudoku_window, coordinatesY[selectedY], coordinatesX[selectedX - 1], " ");
-                    wattroff(sudoku_window, A_UNDERLINE);
-                    wrefresh(sudoku_window);
-                }
-            }
-        }
+        case EXIT_PROMPT:
+            keypad(stdscr, true);
+            curs_set(1);
+            echo();
+            mvwprintw(stdscr, maxHeight - 2, 18, "Do you really want to leave? [y/n]");
+            break;
 
-        if(choice == 'e' || choice == 'E') {
-            // User pressed 'E' or 'e' key
-            return;
-        }
+        case GAME:
+            enterGame();
+            break;
 
-        if(choice >= '1' && choice <= '9') {
-            setNumber(sudoku_window, selectedX, selectedY, choice);
-            if(sudokuCheck()) {
-                GAMES_WON += 1;
-                alertScreen("Congratulations, you won! ");
-                break;
-            }
-        }
+        case ALERT:
+            clearView();
+            move(maxHeight / 2, 10);
+            printw(alertMessage);
+            move((maxHeight / 2) + 1, 10);
+            printw("Press any key to go back to main menu");
+            break;
+
+        default:
+            break;
     }
 }
 
-void gameModeWindow(WINDOW* window) {
-    string modes[3] = {"Easy", "Medium", "Hard"};
-    
-    int choice;
-    int highlighted = gameMode;
-
-    keypad(window, true);
-    wattron(window, A_BOLD);
-    wattron(window, A_UNDERLINE);
-    mvwprintw(window, 5, 5, "Game mode");
-    wattroff(window, A_BOLD);
-    wattroff(window, A_UNDERLINE);
-
-    toolTipMessage("Select an option with ENTER", "Press LEFT_ARROW to close the submenu");
+Screen mainMenuKey(int choice) {
+    switch (choice) {
+        case KEY_UP:
+            if(menuHighlighted > 0) { menuHighlighted--; }
+            break;
+        case KEY_DOWN:
+            if(menuHighlighted < 1) { menuHighlighted++; }
+            break;
+        case KEY_RIGHT:
+        case 10:
+            // User pressed Enter key
+            return menuHighlighted == 0 ? GAME : MODE_MENU;
+        case 101:
+        case 69:
+            // User pressed 'E' or 'e' key
+            promptReturn = MAIN_MENU;
+            return EXIT_PROMPT;
 
-    wrefresh(window);
-    while(1) {
-        for(int i = 0; i < 3; i++) {
-            if(i == highlighted) {
-                highlightText(window, 2 * (i + 1), 28, modes[i].c_str());
-            } else {
-                mvwprintw(window, 2 * (i + 1), 28, modes[i].c_str());
-            }
-        }
+        default:
+            break;
+    }
 
-        choice = wgetch(window);
+    drawMainMenu();
+    return MAIN_MENU;
+}
 
-        switch (choice) {
-            case KEY_LEFT:
-                // Exit submenu on click left but do not select the game mode
-                choice = -10;
-                break;
+Screen modeMenuKey(int choice) {
+    switch (choice) {
+        case 10:
+            // User pressed Enter key
+            gameMode = modeHighlighted;
+            clearScreen(menu_window, 28, 38, 2, 7);
+            return MAIN_MENU;
 
-            case KEY_UP:
-                if(highlighted > 0) { highlighted--; }
-                break;
+        case KEY_LEFT:
+            // Exit submenu on click left but do not select the game mode
+            clearScreen(menu_window, 28, 38, 2, 7);
+            return MAIN_MENU;
 
-            case KEY_DOWN:
-                if(highlighted < 2) { highlighted++; }
-                break;
-            
-            default:
-                break;
-            }
+        case 101:
+        case 69:
+            // User pressed 'E' or 'e' key
+            promptReturn = MODE_MENU;
+            return EXIT_PROMPT;
 
-        if(choice == 10) {
-            // User pressed Enter key
-            clearScreen(window, 28, 38, 2, 7);
-            gameMode = highlighted;
+        case KEY_UP:
+            if(modeHighlighted > 0) { modeHighlighted--; }
             break;
-        }
 
-        if(choice == -10) {
-            clearScreen(window, 28, 38, 2, 7);
+        case KEY_DOWN:
+            if(modeHighlighted < 2) { modeHighlighted++; }
             break;
-        }
 
-        if(choice == 101 || choice == 69) {
-            // User pressed 'E' or 'e' key
+        default:
             break;
-        }
     }
 
-    if(choice == 101 || choice == 69) {
-        exitPrompt(window, highlighted, 1);
-    } else {
-        gameMenuWindow(window, 1);
+    drawModeMenu();
+    return MODE_MENU;
+}
+
+Screen exitPromptKey(int c) {
+    if(c == 121 || c == 89) {
+        // y || Y
+        return QUIT;
     }
 
+    // Any other key
+    mvwprintw(stdscr, maxHeight - 2, 18, "                                      ");
+    refresh();
+    keypad(stdscr, false);
+    curs_set(0);
+    noecho();
+    return promptReturn;
 }
 
-void gameMenuWindow(WINDOW* window, int highlighted) {
-    int choice = 0;
+Screen gameKey(int choice) {
+    if(choice == ERR) {
+        // Input timeout while the board is uncovered
+        view->tick();
+        view->draw();
+        endFrame();
 
-    printGameMode();
+        if(!view->isRevealing()) {
+            wtimeout(sudoku_window, -1);
+        }
+        return GAME;
+    }
 
-    string choices[3] = {"New game", "Game mode"};
+    if(choice == 'w' && selectedY > 0) {
+        selectedY--;
+    }
 
-    keypad(window, true);   // So we can use arrow keys
+    if(choice == 's' && selectedY < 8) {
+        selectedY++;
+    }
 
-    while(1) {
-        mvwprintw(window, 0, 2, " Sudoku puzzle main menu ");
+    if(choice == 'a' && selectedX > 0) {
+        selectedX--;
+    }
 
-        for(int i = 0; i < 2; i++) {
-            if(i == highlighted) {
-                wattron(window, A_REVERSE);
-                mvwprintw(window, 2 * (i + 1) + 1, 5, choices[i].c_str());
-                wattroff(window, A_REVERSE);
+    if(choice == 'd' && selectedX < 8) {
+        selectedX++;
+    }
 
-                if(i == 0) {
-                    toolTipMessage("Press ENTER to start a new game.", "");
-                } else {
-                    toolTipMessage("Press RIGHT_ARROW or ENTER to open submenu.", "");
-                }
+    if(choice == 'e' || choice == 'E') {
+        // User pressed 'E' or 'e' key
+        return QUIT;
+    }
 
-            } else {
-                mvwprintw(window, 2 * (i + 1) + 1, 5, choices[i].c_str());
-            }
-        }
+    // u and r take back and repeat moves, mistakes stay counted
+    bool changed = false;
+    if(choice >= '1' && choice <= '9') {
+        changed = game.setItem(selectedX, selectedY, choice - '0');
+    }
+    if(choice == 'u') {
+        changed = game.undo();
+    }
+    if(choice == 'r') {
+        changed = game.redo();
+    }
 
-        choice = wgetch(window);
-
-        switch (choice) {
-            case KEY_UP:
-                if(highlighted > 0) { highlighted--; }
-                break;
-            case KEY_DOWN:
-                if(highlighted < 1) { highlighted++; }
-                break;
-            case KEY_RIGHT:
-                choice = 10;
-                break;
-
-            default:
-                break;
+    if(changed) {
+        if(game.isWon()) {
+            GAMES_WON += 1;
+            alertMessage = "Congratulations, you won! ";
+            return ALERT;
         }
 
-        if(choice == 10) {
-            // User pressed Enter key
-            break;
-        }
+        move(0, 0);
+        printw("Not yet filled up");
+        printMistakes(game.getMistakes());
 
-        if(choice == 101 || choice == 69) {
-            // User pressed 'E' or 'e' key
-            break;
+        if(game.getMistakes() >= 3) {
+            alertMessage = "Game over...";
+            return ALERT;
         }
     }
 
-    if(choice == 101 || choice == 69) {
-        exitPrompt(window, highlighted, 0);
-    } else {
-        if(highlighted == 0) {
-            startGame();
+    drawBoard();
+    return GAME;
+}
+
+Screen alertKey(int c) {
+    return (char) c ? MAIN_MENU : ALERT;
+}
+
+// Window the keys of a screen are read from
+WINDOW* inputWindow(Screen screen) {
+    if(screen == MAIN_MENU || screen == MODE_MENU) return menu_window;
+    if(screen == GAME) return sudoku_window;
+    return stdscr;
+}
+
+void runScreens() {
+    createWindows();
+
+    Screen screen = MAIN_MENU;
+    enterScreen(screen, QUIT);
+
+    while(screen != QUIT) {
+        int key = readKey(inputWindow(screen), screen == GAME);
+        Screen next = screen;
+
+        switch(screen) {
+            case MAIN_MENU:     next = mainMenuKey(key); break;
+            case MODE_MENU:     next = modeMenuKey(key); break;
+            case EXIT_PROMPT:   next = exitPromptKey(key); break;
+            case GAME:          next = gameKey(key); break;
+            case ALERT:         next = alertKey(key); break;
+            default:            break;
         }
-        
-        if(highlighted == 1) {
-            gameModeWindow(window);
+
+        if(next != screen && next != QUIT) {
+            enterScreen(next, screen);
         }
+        screen = next;
     }
+
+    deleteWindows();
 }
 
 /**
  * --------------------------- START PROGRAM ---------------------------
 */
 
-void mainScreen(int height, int width, int start_y, int start_x) {
-    WINDOW *start_menu_window = newwin(height, width, start_y, start_x);
-    WINDOW *stats_window = newwin(height, width, start_y, start_x + width + 10);
+void printUsage() {
+    std::cout << "Usage:\n"
+        "  sudoku [--animate] [--render-stats] [--record SESSION] [--bank FILE] [--seed S]\n"
+        "  sudoku --replay SESSION\n"
+        "  sudoku --solve FILE [--threads N] [--solver backtracking|dlx|iterative|parallel] [--rules SPEC]\n"
+        "         [--budget-nodes N] [--budget-ms MS] [--stats] [--stats-json FILE]\n"
+        "  sudoku --generate N --level 0|1|2 [--threads N] [--seed S] [--rules SPEC] [--stats] [--stats-json FILE]\n"
+        "  sudoku --dedup FILE [--index INDEX] [--threads N]\n"
+        "  sudoku --verify FILE\n"
+        "  sudoku --serve SOCKET [--threads N] [--solver NAME] [--seed S] [--budget-nodes N] [--budget-ms MS]\n"
+        "  sudoku --load-test SOCKET --count N [--connections C] [--pipeline P]\n"
+        "  sudoku --puzzle ID\n"
+        "  sudoku --build-bank FILE --count N [--threads N] [--seed S]\n"
+        "  sudoku --bank-sample FILE --level 0|1|2 --count N\n";
+}
 
-    getTerminalInfo();
-    info();
-    refresh();
+// Options followed by a value, everything but --stats, --animate and --render-stats
+bool isValueFlag(const string &flag) {
+    static const char *FLAGS[] = {
+        "--solver", "--solve", "--threads", "--generate", "--level", "--count", "--bank", "--build-bank",
+        "--bank-sample", "--seed", "--puzzle", "--serve", "--load-test", "--connections", "--pipeline",
+        "--dedup", "--index", "--verify", "--rules", "--budget-nodes", "--budget-ms", "--record",
+        "--replay", "--stats-json"
+    };
+    for(size_t i = 0; i < sizeof(FLAGS) / sizeof(FLAGS[0]); i++) {
+        if(flag == FLAGS[i]) return true;
+    }
+    return false;
+}
 
-    box(start_menu_window, 0, 0);
-    box(stats_window, 0, 0);
+// The whole text has to be a number of at least min, so "--generate abc" is an error rather than 0
+bool parseNumber(const char *text, long &value, long min) {
+    char *end;
+    errno = 0;
+    value = strtol(text, &end, 10);
+    return end != text && *end == '\0' && errno == 0 && value >= min;
+}
+
+bool parseNumber(const char *text, double &value) {
+    char *end;
+    errno = 0;
+    value = strtod(text, &end);
+    return end != text && *end == '\0' && errno == 0 && value >= 0;
+}
 
-    statsWindow(stats_window);
-    gameMenuWindow(start_menu_window, 0);
+// Seeds and puzzle IDs, base as for strtoull
+bool parseUnsigned(const char *text, uint64_t &value, int base) {
+    char *end;
+    errno = 0;
+    value = strtoull(text, &end, base);
+    return end != text && *end == '\0' && errno == 0 && text[0] != '-';
 }
 
 int main(int argc, char * argv[]) {
 
-    int height, width, start_y, start_x;
-    height = 9;
-    width = 50;
-    start_y = 5;
-    start_x = 10;
-    
+    string solverName = "backtracking";
+    string solvePath = "";
+    int threads = 0;
+    long generateCount = 0;
+    int level = 0;
+    string bankPath = "";
+    string buildBankPath = "";
+    string samplePath = "";
+    long count = 1;
+    bool renderStats = false;
+    uint64_t seed = randomSeed();
+    string puzzleId = "";
+    string servePath = "";
+    string loadTestPath = "";
+    int connections = 4;
+    int pipeline = 16;
+    bool showStats = false;
+    string statsPath = "";
+    string dedupPath = "";
+    string indexPath = "";
+    string verifyPath = "";
+    string rulesSpec = "";
+    string recordPath = "";
+    string replayPath = "";
+    SearchBudget budget = { 0, 0, NULL };
+    bool solverGiven = false;
+    string error = "";
+    for(int i = 1; i < argc && error == ""; i++) {
+        string flag = argv[i];
+        long number = 0;
+
+        if(flag == "--stats") {
+            showStats = true;
+            continue;
+        }
+        if(flag == "--animate") {
+            animateBoard = true;
+            continue;
+        }
+        if(flag == "--render-stats") {
+            renderStats = true;
+            continue;
+        }
+
+        // Every other flag takes a value
+        if(!isValueFlag(flag)) {
+            error = "Unknown option " + flag;
+            break;
+        }
+        if(i + 1 >= argc) {
+            error = flag + " needs a value";
+            break;
+        }
+        const char *value = argv[++i];
+        bool valid = true;
+
+        if(flag == "--solver") {
+            solverName = value;
+            solverGiven = true;
+        } else if(flag == "--solve") {
+            solvePath = value;
+        } else if(flag == "--threads") {
+            valid = parseNumber(value, number, 0) && number <= 1024;
+            threads = number;
+        } else if(flag == "--generate") {
+            valid = parseNumber(value, generateCount, 1);
+        } else if(flag == "--level") {
+            valid = parseNumber(value, number, 0) && number <= 2;
+            level = number;
+        } else if(flag == "--count") {
+            valid = parseNumber(value, count, 1);
+        } else if(flag == "--bank") {
+            bankPath = value;
+        } else if(flag == "--build-bank") {
+            buildBankPath = value;
+        } else if(flag == "--bank-sample") {
+            samplePath = value;
+        } else if(flag == "--seed") {
+            valid = parseUnsigned(value, seed, 0);
+        } else if(flag == "--puzzle") {
+            uint64_t id;
+            valid = parseUnsigned(value, id, 16);
+            puzzleId = value;
+        } else if(flag == "--serve") {
+            servePath = value;
+        } else if(flag == "--load-test") {
+            loadTestPath = value;
+        } else if(flag == "--connections") {
+            valid = parseNumber(value, number, 1) && number <= 4096;
+            connections = number;
+        } else if(flag == "--pipeline") {
+            valid = parseNumber(value, number, 1) && number <= 4096;
+            pipeline = number;
+        } else if(flag == "--dedup") {
+            dedupPath = value;
+        } else if(flag == "--index") {
+            indexPath = value;
+        } else if(flag == "--verify") {
+            verifyPath = value;
+        } else if(flag == "--rules") {
+            rulesSpec = value;
+        } else if(flag == "--budget-nodes") {
+            valid = parseNumber(value, budget.nodes, 0);
+        } else if(flag == "--budget-ms") {
+            valid = parseNumber(value, budget.ms);
+        } else if(flag == "--record") {
+            recordPath = value;
+        } else if(flag == "--replay") {
+            replayPath = value;
+        } else if(flag == "--stats-json") {
+            statsPath = value;
+        }
+
+        if(!valid) error = "Bad value for " + flag + ": " + value;
+    }
+
+    if(error != "") {
+        std::cout << error << "\n";
+        printUsage();
+        return 1;
+    }
+
+    // The game, --generate, the bank and --puzzle always use their own search, a solver would be ignored
+    if(solverGiven) {
+        bool solverMode = servePath != "" || (loadTestPath == "" && generateCount == 0 && buildBankPath == "" &&
+            samplePath == "" && dedupPath == "" && verifyPath == "" && solvePath != "");
+        if(!solverMode) {
+            std::cout << "--solver only works with --solve and --serve\n";
+            return 1;
+        }
+    }
+
+    // Only --solve and --generate know the variant rules, which have a search of their own (that
+    // takes the budget like the iterative solver does)
+    if(rulesSpec != "") {
+        bool rulesMode = servePath == "" && loadTestPath == "" && (generateCount > 0 ||
+            (buildBankPath == "" && samplePath == "" && dedupPath == "" && verifyPath == "" && solvePath != ""));
+        if(!rulesMode) {
+            std::cout << "--rules only works with --solve and --generate\n";
+            return 1;
+        }
+        if(solverGiven) {
+            std::cout << "--rules can't be combined with --solver\n";
+            return 1;
+        }
+    }
+
+    if(servePath != "") {
+        return runServer(servePath, threads, solverName, seed, budget);
+    }
+
+    if(loadTestPath != "") {
+        return runLoadTest(loadTestPath, count, connections, pipeline);
+    }
+
+    // Counters and latency of every puzzle solved or generated (--stats, --stats-json FILE)
+    FILE *statsJson = NULL;
+    if(statsPath != "") {
+        statsJson = fopen(statsPath.c_str(), "w");
+        if(statsJson == NULL) {
+            std::cout << "Can't create " << statsPath << "\n";
+            return 1;
+        }
+    }
+    StatsReport *report = showStats || statsJson != NULL ? new StatsReport(statsJson) : NULL;
+
+    auto finishStats = [&](const char *title, FILE *output) {
+        if(report == NULL) return;
+        if(showStats) report->printSummary(output, title);
+        report->writeSummaryJson(title);
+        if(statsJson != NULL) fclose(statsJson);
+        delete report;
+    };
+
+    // Variant rules (--rules SPEC) are compiled once and shared by every worker
+    RuleTables tables;
+    const RuleTables *rules = NULL;
+    if(rulesSpec != "") {
+        Rules description;
+        string error;
+        if(!parseRules(rulesSpec, description, error) || !tables.compile(description, error)) {
+            std::cout << error << "\n";
+            return 1;
+        }
+        rules = &tables;
+    }
+
+    if(generateCount > 0) {
+        int result = runBulkGenerate(generateCount, level, threads, seed, report, rules);
+        finishStats("generate", stderr);
+        return result;
+    }
+
+    if(buildBankPath != "") {
+        return runBuildBank(buildBankPath, count, threads, seed);
+    }
+
+    if(samplePath != "") {
+        return runBankSample(samplePath, level, count);
+    }
+
+    if(dedupPath != "") {
+        return runDedup(dedupPath, threads, indexPath);
+    }
+
+    if(verifyPath != "") {
+        return runVerify(verifyPath);
+    }
+
+    if(solvePath != "") {
+        // Headless mode, no terminal needed
+        int result = runBatchSolve(solvePath, solverName, threads, budget, report, rules);
+        finishStats("solve", stderr);
+        return result;
+    }
+
+    if(puzzleId != "") {
+        // Prints the puzzle and its solution for an ID shown in the game
+        char line[82];
+        line[81] = '\0';
+
+        Puzzle puzzle = regeneratePuzzle(strtoull(puzzleId.c_str(), NULL, 16));
+        puzzle.puzzle.writeString(line);
+        std::cout << line << "\n";
+        puzzle.solution.writeString(line);
+        std::cout << line << "\n";
+        return 0;
+    }
+
+    if(replayPath != "") {
+        // Replays draw on the same screen as the recording: size, terminal type and animation
+        SessionHeader header;
+        if(!startReplay(replayPath, header)) return 1;
+
+        setenv("LINES", to_string(header.lines).c_str(), 1);
+        setenv("COLUMNS", to_string(header.columns).c_str(), 1);
+        if(header.term[0] != '\0') setenv("TERM", header.term, 1);
+        animateBoard = (header.flags & SESSION_ANIMATE) != 0;
+    } else if(bankPath != "") {
+        bank = new PuzzleBank();
+        if(!bank->open(bankPath)) return 1;
+
+        for(int i = 0; i < 3; i++) {
+            if(bank->getCount(i) == 0) {
+                std::cout << "The bank has no puzzles of level " << i << "\n";
+                return 1;
+            }
+        }
+    } else {
+        // Starts generating right away, so the first game is ready by the time the player picks it
+        puzzles = new PuzzleQueue(3, seed, report);
+    }
+
     start_ncurses();
 
     start_color();
@@ -608,10 +892,31 @@ int main(int argc, char * argv[]) {
     init_pair(3, COLOR_MAGENTA, COLOR_BLACK);
     init_pair(4, COLOR_RED, COLOR_BLACK);
 
-    mainScreen(height, width, start_y, start_x);
+    if(recordPath != "" && !isReplaying() && !startRecording(recordPath, LINES, COLS, animateBoard)) {
+        stop_ncurses();
+        return 1;
+    }
+
+    // Frames are only timed when something reports them, latencies only for the replay percentiles
+    if(renderStats || recordPath != "" || isReplaying()) enableFrameStats(isReplaying());
 
-    endwin();
+    runScreens();
+
+    stop_ncurses();
+    finishSession();
+    delete puzzles;
+    delete bank;
+
+    if(isReplaying()) {
+        writeReplayReport(stdout);
+        return 0;
+    }
+
+    finishStats("game puzzles", stdout);
     std::cout << "\n";
     std::cout << "Program ended.\n";
+    if(renderStats) {
+        printRenderStats(stdout);
+    }
     return 0;
 }
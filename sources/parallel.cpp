@@ -0,0 +1,194 @@
+#include "../headers/parallel.h"
+#include "../headers/stats.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+
+ThreadPool& getSearchPool() {
+    static ThreadPool pool(0);
+    return pool;
+}
+
+template <int BoxN>
+ParallelSearch<BoxN>::ParallelSearch(ThreadPool &pool) : pool(pool) {
+}
+
+// Expands the board until there are enough subtrees for the pool. Returns the solutions met on
+// the way, the first of them is copied to solution
+template <int BoxN>
+int ParallelSearch<BoxN>::split(const Board &board, int limit, std::vector <Board> &subtrees, Board &solution) {
+    size_t target = (size_t) this->pool.getSize() * TASKS_PER_WORKER;
+    std::deque <Board> frontier(1, board);
+    int solutions = 0;
+
+    while(!frontier.empty() && frontier.size() < target && solutions < limit) {
+        Board next = frontier.front();
+        frontier.pop_front();
+
+        int row, col;
+        Mask candidates;
+        int found = next.findConstrainedCell(row, col, candidates);
+
+        if(found == 0) {
+            if(solutions++ == 0) solution = next;
+            continue;
+        }
+        if(found < 0) continue;
+
+        while(candidates) {
+            int number = __builtin_ctz(candidates) + 1;
+            candidates &= candidates - 1;
+
+            frontier.push_back(next);
+            frontier.back().placeNumber(row, col, number);
+        }
+    }
+
+    subtrees.assign(frontier.begin(), frontier.end());
+    return solutions;
+}
+
+template <int BoxN>
+SearchResult ParallelSearch<BoxN>::run(Board &board, int limit, int &solutions, const SearchBudget &budget) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Easy puzzles are settled here, without any task. A pool of one worker gets everything
+    IterativeSearch<BoxN> first;
+    SearchBudget firstBudget = budget;
+    if(this->pool.getSize() > 1 && (budget.nodes == 0 || budget.nodes > SPLIT_NODES)) {
+        firstBudget.nodes = SPLIT_NODES;
+    }
+
+    SearchResult result = limit == 1 ? first.solve(board, firstBudget) : first.count(board, limit, firstBudget);
+    solutions = first.getSolutions();
+    if(result != SEARCH_BUDGET || firstBudget.nodes == budget.nodes) return result;
+
+    SearchBudget taskBudget = { 0, 0, NULL };
+    if(budget.ms > 0) {
+        taskBudget.ms = budget.ms - std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if(taskBudget.ms <= 0) return SEARCH_BUDGET;
+    }
+
+    // Solutions counted by the first pass are found again by the tasks
+    Board solution;
+    std::vector <Board> subtrees;
+    int found = this->split(board, limit, subtrees, solution);
+    if(found >= limit) {
+        if(limit == 1) board = solution;
+        solutions = limit;
+        return SEARCH_SOLVED;
+    }
+
+    if(budget.nodes > 0) {
+        taskBudget.nodes = std::max(1L, (budget.nodes - SPLIT_NODES) / (long) std::max((size_t) 1, subtrees.size()));
+    }
+
+    CancelToken stop;
+    taskBudget.cancel = &stop;
+    std::atomic<int> total(found);
+    std::vector <SearchResult> results(subtrees.size(), SEARCH_CANCELLED);
+    std::vector <Counters> counters(subtrees.size());
+    std::vector <std::future<void> > done;
+
+    for(size_t i = 0; i < subtrees.size(); i++) {
+        std::shared_ptr<std::packaged_task<void()> > task(new std::packaged_task<void()>([&, i]() {
+            takeCounters();
+            IterativeSearch<BoxN> search;
+            if(limit == 1) {
+                results[i] = search.solve(subtrees[i], taskBudget);
+                if(results[i] == SEARCH_SOLVED) stop.cancel();
+            } else {
+                results[i] = search.count(subtrees[i], limit, taskBudget, &total);
+                if(total.load() >= limit) stop.cancel();
+            }
+            counters[i] = takeCounters();
+        }));
+        done.push_back(task->get_future());
+        this->pool.submit([task]() { (*task)(); });
+    }
+
+    // The tasks only watch their own token, a cancel from the caller is passed on to it
+    for(size_t i = 0; i < done.size(); i++) {
+        if(budget.cancel == NULL) {
+            done[i].wait();
+            continue;
+        }
+        while(done[i].wait_for(std::chrono::milliseconds(1)) != std::future_status::ready) {
+            if(budget.cancel->isCancelled()) stop.cancel();
+        }
+    }
+
+    // The tasks counted on the pool threads, the stats belong to the caller's puzzle
+    for(size_t i = 0; i < counters.size(); i++) mergeCounters(counters[i]);
+
+    if(limit == 1) {
+        for(size_t i = 0; i < subtrees.size(); i++) {
+            if(results[i] == SEARCH_SOLVED) {
+                board = subtrees[i];
+                solutions = 1;
+                return SEARCH_SOLVED;
+            }
+        }
+    }
+
+    solutions = std::min(total.load(), limit);
+    if(solutions >= limit) return SEARCH_SOLVED;
+
+    for(size_t i = 0; i < results.size(); i++) {
+        if(results[i] == SEARCH_BUDGET) return SEARCH_BUDGET;
+    }
+    for(size_t i = 0; i < results.size(); i++) {
+        if(results[i] == SEARCH_CANCELLED) return SEARCH_CANCELLED;
+    }
+    return limit == 1 ? SEARCH_UNSOLVABLE : SEARCH_SOLVED;
+}
+
+template <int BoxN>
+SearchResult ParallelSearch<BoxN>::solve(Board &board, const SearchBudget &budget) {
+    int solutions;
+    return this->run(board, 1, solutions, budget);
+}
+
+template <int BoxN>
+SearchResult ParallelSearch<BoxN>::count(const Board &board, int limit, int &solutions, const SearchBudget &budget) {
+    Board copy = board;
+    return this->run(copy, limit, solutions, budget);
+}
+
+template class ParallelSearch<2>;
+template class ParallelSearch<3>;
+template class ParallelSearch<4>;
+template class ParallelSearch<5>;
+
+ParallelSolver::ParallelSolver() : search(getSearchPool()) {
+}
+
+const char* ParallelSolver::getName() {
+    return "parallel";
+}
+
+bool ParallelSolver::solve(Sudoku &sudoku) {
+    SearchBudget unlimited = { 0, 0, NULL };
+    return this->search.solve(sudoku, unlimited) == SEARCH_SOLVED;
+}
+
+SearchResult ParallelSolver::solveBounded(Sudoku &sudoku, const SearchBudget &budget) {
+    return this->search.solve(sudoku, budget);
+}
+
+int ParallelSolver::countSolutions(Sudoku &sudoku, int limit) {
+    SearchBudget unlimited = { 0, 0, NULL };
+    int solutions;
+    this->search.count(sudoku, limit, solutions, unlimited);
+    return solutions;
+}
+
+SearchResult ParallelSolver::countBounded(Sudoku &sudoku, int limit, int &solutions, const SearchBudget &budget) {
+    return this->search.count(sudoku, limit, solutions, budget);
+}
+
+bool ParallelSolver::isBounded() {
+    return true;
+}
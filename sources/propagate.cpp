@@ -0,0 +1,329 @@
+#include "../headers/propagate.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PROPAGATE_X86
+#endif
+
+/**
+ * Board state shared by the kernels. Rows are padded to 16 lanes of 16 bits,
+ * so one row of cells fits a single AVX2 register (or two SSE2 registers).
+*/
+struct PropagateState {
+    alignas(32) uint16_t colMask[16];           // Lane = column
+    alignas(32) uint16_t bandBoxMask[3][16];    // Lane = column, mask of the box covering it in the band
+    alignas(32) uint16_t empty[9][16];          // 0xFFFF for empty cells, 0 for filled cells and padding
+    alignas(32) uint16_t cand[9][16];           // Kernel output: candidates of every empty cell
+    alignas(32) uint16_t colOnce[16];           // Kernel output: candidate at least once in the column
+    alignas(32) uint16_t colMore[16];           // Kernel output: candidate more than once in the column
+    uint32_t naked[9];                          // Kernel output: bits 2j and 2j+1 set when cell (r, j) has a single candidate
+    uint16_t rowMask[9];
+    uint16_t boxMask[9];
+    int value[9][9];
+};
+
+typedef bool (*CandidateKernel)(PropagateState &state);
+
+// Every kernel returns false when an empty cell has no candidate left
+
+static bool candidatesScalar(PropagateState &s) {
+    bool valid = true;
+
+    memset(s.colOnce, 0, sizeof(s.colOnce));
+    memset(s.colMore, 0, sizeof(s.colMore));
+
+    for(int r = 0; r < 9; r++) {
+        s.naked[r] = 0;
+        for(int j = 0; j < 9; j++) {
+            uint16_t c = ~(s.rowMask[r] | s.colMask[j] | s.bandBoxMask[r / 3][j]) & 0x1FF & s.empty[r][j];
+            s.cand[r][j] = c;
+
+            if(s.empty[r][j] && c == 0) valid = false;
+            if(c != 0 && (c & (c - 1)) == 0) s.naked[r] |= 3u << (2 * j);
+
+            s.colMore[j] |= s.colOnce[j] & c;
+            s.colOnce[j] |= c;
+        }
+    }
+
+    return valid;
+}
+
+#ifdef PROPAGATE_X86
+
+static bool candidatesSse2(PropagateState &s) {
+    const __m128i all = _mm_set1_epi16(0x1FF);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i invalid = zero;
+    __m128i once[2] = {zero, zero};
+    __m128i more[2] = {zero, zero};
+
+    for(int r = 0; r < 9; r++) {
+        __m128i row = _mm_set1_epi16(s.rowMask[r]);
+        uint32_t naked = 0;
+
+        for(int half = 0; half < 2; half++) {
+            __m128i used = _mm_or_si128(row, _mm_or_si128(
+                _mm_load_si128((const __m128i*) &s.colMask[half * 8]),
+                _mm_load_si128((const __m128i*) &s.bandBoxMask[r / 3][half * 8])));
+            __m128i empty = _mm_load_si128((const __m128i*) &s.empty[r][half * 8]);
+            __m128i c = _mm_and_si128(_mm_andnot_si128(used, all), empty);
+            _mm_store_si128((__m128i*) &s.cand[r][half * 8], c);
+
+            __m128i none = _mm_cmpeq_epi16(c, zero);
+            invalid = _mm_or_si128(invalid, _mm_and_si128(none, empty));
+
+            __m128i single = _mm_andnot_si128(none, _mm_cmpeq_epi16(_mm_and_si128(c, _mm_sub_epi16(c, one)), zero));
+            naked |= (uint32_t) _mm_movemask_epi8(single) << (16 * half);
+
+            more[half] = _mm_or_si128(more[half], _mm_and_si128(once[half], c));
+            once[half] = _mm_or_si128(once[half], c);
+        }
+        s.naked[r] = naked;
+    }
+
+    for(int half = 0; half < 2; half++) {
+        _mm_store_si128((__m128i*) &s.colOnce[half * 8], once[half]);
+        _mm_store_si128((__m128i*) &s.colMore[half * 8], more[half]);
+    }
+
+    return _mm_movemask_epi8(invalid) == 0;
+}
+
+__attribute__((target("avx2")))
+static bool candidatesAvx2(PropagateState &s) {
+    const __m256i all = _mm256_set1_epi16(0x1FF);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i col = _mm256_load_si256((const __m256i*) s.colMask);
+    __m256i invalid = zero;
+    __m256i once = zero;
+    __m256i more = zero;
+
+    for(int r = 0; r < 9; r++) {
+        __m256i used = _mm256_or_si256(_mm256_set1_epi16(s.rowMask[r]),
+            _mm256_or_si256(col, _mm256_load_si256((const __m256i*) s.bandBoxMask[r / 3])));
+        __m256i empty = _mm256_load_si256((const __m256i*) s.empty[r]);
+        __m256i c = _mm256_and_si256(_mm256_andnot_si256(used, all), empty);
+        _mm256_store_si256((__m256i*) s.cand[r], c);
+
+        __m256i none = _mm256_cmpeq_epi16(c, zero);
+        invalid = _mm256_or_si256(invalid, _mm256_and_si256(none, empty));
+
+        __m256i single = _mm256_andnot_si256(none, _mm256_cmpeq_epi16(_mm256_and_si256(c, _mm256_sub_epi16(c, one)), zero));
+        s.naked[r] = (uint32_t) _mm256_movemask_epi8(single);
+
+        more = _mm256_or_si256(more, _mm256_and_si256(once, c));
+        once = _mm256_or_si256(once, c);
+    }
+
+    _mm256_store_si256((__m256i*) s.colOnce, once);
+    _mm256_store_si256((__m256i*) s.colMore, more);
+
+    return _mm256_testz_si256(invalid, invalid);
+}
+
+#endif
+
+struct KernelChoice {
+    CandidateKernel kernel;
+    const char *name;
+};
+
+static KernelChoice detectKernel() {
+    KernelChoice choice = {candidatesScalar, "scalar"};
+
+#ifdef PROPAGATE_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        choice.kernel = candidatesAvx2;
+        choice.name = "avx2";
+    } else if(__builtin_cpu_supports("sse2")) {
+        choice.kernel = candidatesSse2;
+        choice.name = "sse2";
+    }
+#endif
+
+    return choice;
+}
+
+static KernelChoice& currentKernel() {
+    static KernelChoice choice = detectKernel();
+    return choice;
+}
+
+const char* getPropagateKernel() {
+    return currentKernel().name;
+}
+
+bool setPropagateKernel(const char *name) {
+    KernelChoice &choice = currentKernel();
+
+    if(strcmp(name, "scalar") == 0) {
+        choice.kernel = candidatesScalar;
+        choice.name = "scalar";
+        return true;
+    }
+
+#ifdef PROPAGATE_X86
+    if(strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        choice.kernel = candidatesSse2;
+        choice.name = "sse2";
+        return true;
+    }
+    if(strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        choice.kernel = candidatesAvx2;
+        choice.name = "avx2";
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+// Places number unless it clashes with a placement made earlier in the same round,
+// which means the board has no solution.
+// Returns 1 when placed, 0 when the cell already holds number and -1 on a clash
+static int place(PropagateState &s, int row, int col, int number) {
+    if(s.value[row][col] != 0) return s.value[row][col] == number ? 0 : -1;
+
+    uint16_t bit = 1 << (number - 1);
+    int box = (row / 3) * 3 + col / 3;
+    if((s.rowMask[row] | s.colMask[col] | s.boxMask[box]) & bit) return -1;
+
+    s.value[row][col] = number;
+    s.empty[row][col] = 0;
+    s.rowMask[row] |= bit;
+    s.colMask[col] |= bit;
+    s.boxMask[box] |= bit;
+    s.bandBoxMask[row / 3][col] |= bit;
+    s.bandBoxMask[row / 3][(col / 3) * 3 + (col + 1) % 3] |= bit;
+    s.bandBoxMask[row / 3][(col / 3) * 3 + (col + 2) % 3] |= bit;
+    return 1;
+}
+
+// Applies one round of naked and hidden singles. Returns the number of cells filled or -1
+static int applySingles(PropagateState &s) {
+    int filled = 0;
+
+    // Naked singles
+    for(int r = 0; r < 9; r++) {
+        uint32_t naked = s.naked[r];
+        while(naked) {
+            int j = __builtin_ctz(naked) / 2;
+            naked &= ~(3u << (2 * j));
+
+            int placed = place(s, r, j, __builtin_ctz(s.cand[r][j]) + 1);
+            if(placed < 0) return -1;
+            filled += placed;
+        }
+    }
+
+    // Hidden singles in columns, counted by the kernel for all columns at once
+    for(int j = 0; j < 9; j++) {
+        uint16_t used = 0;
+        for(int r = 0; r < 9; r++) {
+            if(s.empty[r][j] == 0 && s.cand[r][j] == 0) used |= 1 << (s.value[r][j] - 1);
+        }
+        if((s.colOnce[j] | used) != 0x1FF) return -1;   // Some number fits nowhere in the column
+
+        uint16_t hidden = s.colOnce[j] & ~s.colMore[j];
+        while(hidden) {
+            uint16_t bit = hidden & -hidden;
+            hidden &= hidden - 1;
+
+            for(int r = 0; r < 9; r++) {
+                if(s.cand[r][j] & bit) {
+                    int placed = place(s, r, j, __builtin_ctz(bit) + 1);
+                    if(placed < 0) return -1;
+                    filled += placed;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Hidden singles in rows and boxes
+    for(int unit = 0; unit < 18; unit++) {
+        uint16_t once = 0, more = 0, used = 0;
+        int rows[9], cols[9];
+
+        for(int k = 0; k < 9; k++) {
+            if(unit < 9) {
+                rows[k] = unit;
+                cols[k] = k;
+            } else {
+                rows[k] = ((unit - 9) / 3) * 3 + k / 3;
+                cols[k] = ((unit - 9) % 3) * 3 + k % 3;
+            }
+
+            uint16_t c = s.cand[rows[k]][cols[k]];
+            more |= once & c;
+            once |= c;
+            if(c == 0 && s.value[rows[k]][cols[k]] != 0) used |= 1 << (s.value[rows[k]][cols[k]] - 1);
+        }
+        if((once | used) != 0x1FF) return -1;
+
+        uint16_t hidden = once & ~more;
+        while(hidden) {
+            uint16_t bit = hidden & -hidden;
+            hidden &= hidden - 1;
+
+            for(int k = 0; k < 9; k++) {
+                if(s.cand[rows[k]][cols[k]] & bit) {
+                    int placed = place(s, rows[k], cols[k], __builtin_ctz(bit) + 1);
+                    if(placed < 0) return -1;
+                    filled += placed;
+                    break;
+                }
+            }
+        }
+    }
+
+    return filled;
+}
+
+int propagateSingles(Sudoku &sudoku) {
+    PropagateState s;
+    memset(&s, 0, sizeof(s));
+
+    for(int r = 0; r < 9; r++) {
+        for(int j = 0; j < 9; j++) {
+            int number = sudoku.getItem(r, j);
+            if(number == 0) {
+                s.empty[r][j] = 0xFFFF;
+            } else if(place(s, r, j, number) < 0) {
+                return -1;      // Conflicting givens
+            }
+        }
+    }
+
+    int original[9][9];
+    memcpy(original, s.value, sizeof(original));
+
+    CandidateKernel kernel = currentKernel().kernel;
+    int total = 0;
+
+    while(1) {
+        if(!kernel(s)) return -1;
+
+        int filled = applySingles(s);
+        if(filled < 0) return -1;
+        if(filled == 0) break;
+
+        total += filled;
+    }
+
+    for(int r = 0; r < 9; r++) {
+        for(int j = 0; j < 9; j++) {
+            if(original[r][j] == 0 && s.value[r][j] != 0) {
+                sudoku.setItem(r, j, s.value[r][j]);
+            }
+        }
+    }
+
+    return total;
+}
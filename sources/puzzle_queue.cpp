@@ -0,0 +1,103 @@
+#include "../headers/puzzle_queue.h"
+#include <chrono>
+
+PuzzleQueue::PuzzleQueue(int capacity, uint64_t seed, StatsReport *report) {
+    // One stream per level, so the puzzles of a level don't depend on which queue was refilled first
+    Random seeds(seed);
+    for(int i = 0; i < LEVELS; i++) this->random.push_back(Random(seeds.next()));
+    this->report = report;
+    this->generated = 0;
+    this->capacity = capacity > 0 ? capacity : 1;
+    this->wanted = -1;
+    this->stopping = false;
+    this->worker = std::thread(&PuzzleQueue::workerLoop, this);
+}
+
+PuzzleQueue::~PuzzleQueue() {
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    this->worker.join();
+}
+
+// Level to generate next: the one somebody waits for, otherwise the emptiest queue.
+// Returns -1 when every queue is full. Called with the lock held
+int PuzzleQueue::nextLevel() {
+    if(this->wanted >= 0 && this->ready[this->wanted].size() < this->capacity) return this->wanted;
+
+    int level = -1;
+    for(int i = 0; i < LEVELS; i++) {
+        if(this->ready[i].size() >= this->capacity) continue;
+        if(level < 0 || this->ready[i].size() < this->ready[level].size()) level = i;
+    }
+
+    return level;
+}
+
+void PuzzleQueue::workerLoop() {
+    while(1) {
+        int level;
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+            while(!this->stopping && (level = this->nextLevel()) < 0) {
+                this->changed.wait(guard);
+            }
+            if(this->stopping) return;
+        }
+
+        // Generating takes the most time, the lock is not held meanwhile
+        takeCounters();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        Puzzle puzzle = generatePuzzle(level, this->random[level].next());
+
+        if(this->report != NULL) {
+            PuzzleStats stats;
+            stats.index = this->generated;
+            stats.id = puzzle.id;
+            stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats.counters = takeCounters();
+            this->report->add(stats);
+        }
+        this->generated++;
+
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+            this->ready[level].push_back(puzzle);
+        }
+        this->changed.notify_all();
+    }
+}
+
+Puzzle PuzzleQueue::take(int level) {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    while(this->ready[level].empty()) {
+        this->wanted = level;
+        this->changed.notify_all();
+        this->changed.wait(guard);
+    }
+    this->wanted = -1;
+
+    Puzzle puzzle = this->ready[level].front();
+    this->ready[level].pop_front();
+
+    // Wakes up the worker to refill the queue
+    this->changed.notify_all();
+    return puzzle;
+}
+
+bool PuzzleQueue::tryTake(int level, Puzzle &puzzle) {
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+        if(this->ready[level].empty()) return false;
+
+        puzzle = this->ready[level].front();
+        this->ready[level].pop_front();
+    }
+
+    this->changed.notify_all();
+    return true;
+}
@@ -0,0 +1,25 @@
+#include "../headers/random.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+
+// splitmix64 spreads the seed over the whole state, so seeds 1, 2, 3... give unrelated sequences
+Random::Random(uint64_t seed) {
+    for(int i = 0; i < 4; i++) {
+        seed += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        this->state[i] = z ^ (z >> 31);
+    }
+}
+
+uint64_t randomSeed() {
+    static std::atomic<uint64_t> calls(0);
+
+    std::random_device device;
+    uint64_t seed = ((uint64_t) device() << 32) ^ device();
+    seed ^= std::chrono::steady_clock::now().time_since_epoch().count();
+
+    return Random(seed + calls++).next();
+}
@@ -0,0 +1,229 @@
+#include "../headers/renderer.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static const int REVEAL_STEP = 9;   // Cells uncovered per animation tick
+
+// Columns
+static const int cellX[9] = {
+    3, 6, 9,  15, 18, 21,  27, 30, 33
+};
+
+// Lines
+static const int cellY[9] = {
+    1, 3, 5,  7, 9, 11,  13, 15, 17
+};
+
+/**
+ * --------------------------- OUTPUT COUNTING ---------------------------
+*/
+
+// ncurses needs the real terminal as its output to set it up, so the bytes it writes are
+// taken from the kernel's count of everything this process wrote (Linux only, 0 elsewhere)
+long getOutputBytes() {
+    FILE *io = fopen("/proc/self/io", "r");
+    if(io == NULL) return 0;
+
+    char line[64];
+    long bytes = 0;
+    while(fgets(line, sizeof(line), io) != NULL) {
+        if(sscanf(line, "wchar: %ld", &bytes) == 1) break;
+    }
+
+    fclose(io);
+    return bytes;
+}
+
+/**
+ * --------------------------- FRAME TIMING ---------------------------
+*/
+
+static const char *PATH_NAMES[FRAME_PATHS] = {"menu", "navigation", "entry", "tick"};
+
+static RenderStats stats[FRAME_PATHS];
+static std::vector <double> latencies[FRAME_PATHS];
+static std::chrono::steady_clock::time_point frameStart;
+static long frameBytes = 0;
+static FramePath framePath = MENU_FRAME;
+static bool frameOpen = false;
+static bool timingFrames = false;
+static bool keepingLatencies = false;
+
+void enableFrameStats(bool keepLatencies) {
+    timingFrames = true;
+    keepingLatencies = keepLatencies;
+}
+
+void beginFrame(FramePath path) {
+    if(!timingFrames) return;
+    frameStart = std::chrono::steady_clock::now();
+    frameBytes = getOutputBytes();
+    framePath = path;
+    frameOpen = true;
+}
+
+void endFrame() {
+    doupdate();
+}
+
+void finishFrame() {
+    // Output that wasn't caused by an input event (the first screen) isn't a frame
+    if(!frameOpen) return;
+    frameOpen = false;
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    RenderStats &path = stats[framePath];
+    path.frames++;
+    path.bytes += getOutputBytes() - frameBytes;
+    path.totalMs += ms;
+    if(ms > path.maxMs) path.maxMs = ms;
+    if(keepingLatencies) latencies[framePath].push_back(ms);
+}
+
+RenderStats getRenderStats(FramePath path) {
+    return stats[path];
+}
+
+void printRenderStats(FILE *output) {
+    for(int i = 0; i < FRAME_PATHS; i++) {
+        const RenderStats &path = stats[i];
+        if(path.frames == 0) continue;
+
+        fprintf(output, "%-10s frames: %ld, %.0f bytes/frame, latency avg %.3f ms, max %.3f ms\n", PATH_NAMES[i],
+            path.frames, (double) path.bytes / path.frames, path.totalMs / path.frames, path.maxMs);
+    }
+}
+
+// Latency below which p percent of the frames stay, sorted has to be in ascending order
+static double percentile(const std::vector <double> &sorted, double p) {
+    if(sorted.empty()) return 0;
+    return sorted[(size_t) (p / 100 * (sorted.size() - 1) + 0.5)];
+}
+
+void writeRenderStatsJson(FILE *output) {
+    fprintf(output, "{");
+    for(int i = 0; i < FRAME_PATHS; i++) {
+        const RenderStats &path = stats[i];
+        std::vector <double> sorted = latencies[i];
+        std::sort(sorted.begin(), sorted.end());
+
+        fprintf(output, "%s\"%s\":{\"frames\":%ld,\"bytesPerFrame\":%.1f,\"p50\":%.4f,\"p99\":%.4f,\"max\":%.4f}",
+            i > 0 ? "," : "", PATH_NAMES[i], path.frames, path.frames > 0 ? (double) path.bytes / path.frames : 0.0,
+            percentile(sorted, 50), percentile(sorted, 99), path.maxMs);
+    }
+    fprintf(output, "}");
+}
+
+/**
+ * --------------------------- BOARD VIEW ---------------------------
+*/
+
+BoardView::BoardView(WINDOW *window) {
+    this->window = window;
+    this->revealed = 81;
+
+    for(int x = 0; x < 9; x++) {
+        for(int y = 0; y < 9; y++) {
+            this->wanted[x][y].number = 0;
+            this->wanted[x][y].style = BLANK;
+        }
+    }
+
+    this->invalidate();
+}
+
+void BoardView::setCell(int x, int y, int number, CellStyle style) {
+    this->wanted[x][y].number = number;
+    this->wanted[x][y].style = style;
+}
+
+void BoardView::invalidate() {
+    for(int x = 0; x < 9; x++) {
+        for(int y = 0; y < 9; y++) {
+            this->shown[x][y].number = -1;
+        }
+    }
+    this->gridDrawn = false;
+}
+
+void BoardView::startReveal() {
+    this->revealed = 0;
+}
+
+bool BoardView::isRevealing() {
+    return this->revealed < 81;
+}
+
+void BoardView::tick() {
+    this->revealed += REVEAL_STEP;
+    if(this->revealed > 81) this->revealed = 81;
+}
+
+void BoardView::drawCell(int x, int y) {
+    const Cell &cell = this->shown[x][y];
+
+    switch(cell.style) {
+        case BLANK:
+            wattron(this->window, A_UNDERLINE);
+            mvwaddch(this->window, cellY[y], cellX[x], ' ');
+            wattroff(this->window, A_UNDERLINE);
+            break;
+        case CURSOR:
+            wattron(this->window, A_UNDERLINE);
+            mvwaddch(this->window, cellY[y], cellX[x], '*');
+            wattroff(this->window, A_UNDERLINE);
+            break;
+        case NUMBER:
+            mvwaddch(this->window, cellY[y], cellX[x], '0' + cell.number);
+            break;
+        case SELECTED:
+            wattron(this->window, A_BOLD);
+            mvwaddch(this->window, cellY[y], cellX[x], '0' + cell.number);
+            wattroff(this->window, A_BOLD);
+            break;
+        case WRONG:
+            wattron(this->window, COLOR_PAIR(4) | A_BOLD);
+            mvwaddch(this->window, cellY[y], cellX[x], '0' + cell.number);
+            wattroff(this->window, COLOR_PAIR(4) | A_BOLD);
+            break;
+        case CONFLICT:
+            wattron(this->window, COLOR_PAIR(2) | A_BOLD);
+            mvwaddch(this->window, cellY[y], cellX[x], '0' + cell.number);
+            wattroff(this->window, COLOR_PAIR(2) | A_BOLD);
+            break;
+    }
+}
+
+int BoardView::draw() {
+    if(!this->gridDrawn) {
+        box(this->window, 0, 0);
+        mvwhline(this->window, 6, 1, ACS_HLINE, 35);
+        mvwhline(this->window, 12, 1, ACS_HLINE, 35);
+        mvwvline(this->window, 1, 12, ACS_VLINE, 17);
+        mvwvline(this->window, 1, 24, ACS_VLINE, 17);
+        this->gridDrawn = true;
+    }
+
+    int drawn = 0;
+    for(int y = 0; y < 9; y++) {
+        for(int x = 0; x < 9; x++) {
+            Cell cell = this->wanted[x][y];
+
+            // Cells the reveal animation hasn't reached yet stay blank
+            if(y * 9 + x >= this->revealed) {
+                cell.number = 0;
+                cell.style = BLANK;
+            }
+
+            if(cell.number == this->shown[x][y].number && cell.style == this->shown[x][y].style) continue;
+
+            this->shown[x][y] = cell;
+            this->drawCell(x, y);
+            drawn++;
+        }
+    }
+
+    wnoutrefresh(this->window);
+    return drawn;
+}
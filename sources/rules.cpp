@@ -0,0 +1,259 @@
+#include "../headers/rules.h"
+#include <cstdlib>
+#include <cstring>
+
+void Rules::addUnit(const int *cells, int size, int sum) {
+    Unit unit;
+    for(int k = 0; k < size; k++) unit.cells[k] = cells[k];
+    unit.size = size;
+    unit.sum = sum;
+    this->units.push_back(unit);
+}
+
+void Rules::addRows() {
+    for(int row = 0; row < 9; row++) {
+        int cells[9];
+        for(int k = 0; k < 9; k++) cells[k] = row * 9 + k;
+        this->addUnit(cells, 9);
+    }
+}
+
+void Rules::addColumns() {
+    for(int col = 0; col < 9; col++) {
+        int cells[9];
+        for(int k = 0; k < 9; k++) cells[k] = k * 9 + col;
+        this->addUnit(cells, 9);
+    }
+}
+
+void Rules::addBoxes() {
+    for(int box = 0; box < 9; box++) {
+        int cells[9];
+        for(int k = 0; k < 9; k++) cells[k] = ((box / 3) * 3 + k / 3) * 9 + (box % 3) * 3 + k % 3;
+        this->addUnit(cells, 9);
+    }
+}
+
+void Rules::addDiagonals() {
+    int down[9], up[9];
+    for(int k = 0; k < 9; k++) {
+        down[k] = k * 9 + k;
+        up[k] = k * 9 + 8 - k;
+    }
+    this->addUnit(down, 9);
+    this->addUnit(up, 9);
+}
+
+// Groups the cells by their character in the order each character first shows up
+static int groupCells(const char *map, char skip, int cells[81][81], int sizes[81]) {
+    char names[81];
+    int groups = 0;
+
+    for(int i = 0; i < 81; i++) {
+        if(map[i] == skip) continue;
+
+        int group = 0;
+        while(group < groups && names[group] != map[i]) group++;
+        if(group == groups) {
+            names[groups] = map[i];
+            sizes[groups++] = 0;
+        }
+        cells[group][sizes[group]++] = i;
+    }
+
+    return groups;
+}
+
+bool Rules::addRegions(const char *map) {
+    if(strlen(map) != 81) return false;
+
+    int cells[81][81], sizes[81];
+    int groups = groupCells(map, '\0', cells, sizes);
+    if(groups != 9) return false;
+
+    for(int group = 0; group < 9; group++) {
+        if(sizes[group] != 9) return false;
+    }
+    for(int group = 0; group < 9; group++) {
+        this->addUnit(cells[group], 9);
+    }
+
+    return true;
+}
+
+bool Rules::addCages(const char *map, const std::vector <int> &sums) {
+    if(strlen(map) != 81) return false;
+
+    int cells[81][81], sizes[81];
+    int groups = groupCells(map, '.', cells, sizes);
+    if(groups != (int) sums.size()) return false;
+
+    for(int group = 0; group < groups; group++) {
+        int size = sizes[group];
+        // Smallest and largest sums of size different numbers
+        if(size > 9 || sums[group] < size * (size + 1) / 2 || sums[group] > size * (19 - size) / 2) return false;
+    }
+    for(int group = 0; group < groups; group++) {
+        this->addUnit(cells[group], sizes[group], sums[group]);
+    }
+
+    return true;
+}
+
+const std::vector <Unit>& Rules::getUnits() const {
+    return this->units;
+}
+
+bool parseRules(const std::string &spec, Rules &rules, std::string &error) {
+    bool boxes = true;
+    std::vector <std::string> parts;
+    size_t start = 0;
+
+    while(start <= spec.size()) {
+        size_t end = spec.find('+', start);
+        if(end == std::string::npos) end = spec.size();
+        parts.push_back(spec.substr(start, end - start));
+        start = end + 1;
+    }
+
+    rules.addRows();
+    rules.addColumns();
+
+    for(size_t i = 0; i < parts.size(); i++) {
+        const std::string &part = parts[i];
+
+        if(part == "classic") continue;
+
+        if(part == "x") {
+            rules.addDiagonals();
+        } else if(part.compare(0, 7, "jigsaw:") == 0) {
+            if(!rules.addRegions(part.c_str() + 7)) {
+                error = "Jigsaw regions need 81 characters forming 9 regions of 9 cells";
+                return false;
+            }
+            boxes = false;
+        } else if(part.compare(0, 7, "killer:") == 0) {
+            size_t colon = part.find(':', 7);
+            if(colon == std::string::npos) {
+                error = "Killer cages need a map and their sums (killer:MAP:SUM,SUM,...)";
+                return false;
+            }
+
+            std::vector <int> sums;
+            const char *cursor = part.c_str() + colon + 1;
+            while(*cursor != '\0') {
+                char *end;
+                sums.push_back((int) strtol(cursor, &end, 10));
+                if(end == cursor || (*end != ',' && *end != '\0')) {
+                    error = "Killer cage sums have to be numbers separated by commas";
+                    return false;
+                }
+                cursor = *end == ',' ? end + 1 : end;
+            }
+
+            if(!rules.addCages(part.substr(7, colon - 7).c_str(), sums)) {
+                error = "Killer cages need an 81 character map, one possible sum per cage and at most 9 cells per cage";
+                return false;
+            }
+        } else {
+            error = "Unknown rule: " + part;
+            return false;
+        }
+    }
+
+    if(boxes) rules.addBoxes();
+    return true;
+}
+
+bool RuleTables::compile(const Rules &rules, std::string &error) {
+    const std::vector <Unit> &units = rules.getUnits();
+    if(units.size() > MAX_UNITS) {
+        error = "Too many units";
+        return false;
+    }
+
+    this->unitCount = units.size();
+    memset(this->cellUnitCount, 0, sizeof(this->cellUnitCount));
+    memset(this->cellCageCount, 0, sizeof(this->cellCageCount));
+
+    bool peer[81][81];
+    memset(peer, 0, sizeof(peer));
+
+    for(int u = 0; u < this->unitCount; u++) {
+        const Unit &unit = units[u];
+        this->unitSize[u] = unit.size;
+        this->unitSum[u] = unit.sum;
+
+        for(int k = 0; k < unit.size; k++) {
+            int cell = unit.cells[k];
+            this->unitCells[u][k] = cell;
+
+            uint8_t &count = unit.sum > 0 ? this->cellCageCount[cell] : this->cellUnitCount[cell];
+            if(count == MAX_CELL_UNITS) {
+                error = "A cell is in too many units";
+                return false;
+            }
+            (unit.sum > 0 ? this->cellCages[cell] : this->cellUnits[cell])[count++] = u;
+
+            for(int other = 0; other < unit.size; other++) {
+                if(other != k) peer[cell][unit.cells[other]] = true;
+            }
+        }
+    }
+
+    for(int cell = 0; cell < 81; cell++) {
+        this->peerCount[cell] = 0;
+        for(int other = 0; other < 81; other++) {
+            if(peer[cell][other]) this->peers[cell][this->peerCount[cell]++] = other;
+        }
+    }
+
+    return true;
+}
+
+// Union of every set of different numbers, by the numbers already used, set size and sum
+struct CageTable {
+    uint16_t candidates[512][10][46];
+
+    CageTable() {
+        memset(this->candidates, 0, sizeof(this->candidates));
+
+        for(int set = 0; set < 512; set++) {
+            int size = __builtin_popcount(set);
+            int sum = 0;
+            for(int number = 1; number <= 9; number++) {
+                if(set & (1 << (number - 1))) sum += number;
+            }
+
+            // Every used mask not overlapping the set, the subsets of its complement
+            int rest = 511 & ~set;
+            for(int used = rest; ; used = (used - 1) & rest) {
+                this->candidates[used][size][sum] |= set;
+                if(used == 0) break;
+            }
+        }
+    }
+};
+
+static const CageTable CAGES;
+
+uint16_t getCageCandidates(uint16_t used, int empty, int remaining) {
+    if(remaining < 0 || remaining > 45) return 0;
+    return CAGES.candidates[used][empty][remaining];
+}
+
+const RuleTables& getClassicRules() {
+    struct ClassicTables : RuleTables {
+        ClassicTables() {
+            Rules rules;
+            std::string error;
+            rules.addRows();
+            rules.addColumns();
+            rules.addBoxes();
+            this->compile(rules, error);
+        }
+    };
+
+    static const ClassicTables tables;
+    return tables;
+}
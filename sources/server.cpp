@@ -0,0 +1,744 @@
+#include "../headers/server.h"
+#include "../headers/generator.h"
+#include "../headers/puzzle_queue.h"
+#include "../headers/solver.h"
+#include "../headers/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const int BATCH_REQUESTS = 64;       // Requests handed to a worker at once
+static const size_t MAX_LINE = 1024;        // Longer requests close the connection
+static const int CACHE_PER_LEVEL = 32;      // Puzzles the background generator keeps ready
+static const int MAX_EVENTS = 64;
+static const size_t MAX_OUTPUT = 1 << 20;   // Queued response bytes at which a connection stops being read
+static const uint64_t MAX_IN_FLIGHT = 1024; // Same for requests without a response yet
+
+/**
+ * --------------------------- REQUESTS ---------------------------
+*/
+
+struct Request {
+    uint64_t connection;
+    uint64_t sequence;      // Position of the request on its connection
+    std::string line;
+};
+
+struct Response {
+    uint64_t connection;
+    uint64_t sequence;
+    std::string text;       // Including the '\n'
+};
+
+struct ServerContext {
+    std::vector <Solver*> solvers;      // One per worker
+    PuzzleQueue *cache;
+    uint64_t seed;
+    std::atomic<uint64_t> generated;    // Puzzles generated on workers, seed + generated is the next seed
+    SearchBudget budget;                // Of every SOLVE, watches cancel
+    CancelToken cancel;                 // Triggered on shutdown, so running searches give up
+};
+
+// Reads an 81 character board, false when the text isn't one
+static bool parseBoard(const std::string &text, Sudoku &sudoku) {
+    return text.size() == 81 && sudoku.loadString(text.c_str());
+}
+
+static std::string handleRequest(const std::string &line, ServerContext &context, Solver &solver) {
+    size_t space = line.find(' ');
+    std::string command = line.substr(0, space);
+    std::string argument = space == std::string::npos ? "" : line.substr(space + 1);
+
+    char board[82];
+    board[81] = '\0';
+
+    if(command == "GEN") {
+        if(argument.size() != 1 || argument[0] < '0' || argument[0] > '2') return "ERR level has to be 0, 1 or 2\n";
+        int level = argument[0] - '0';
+
+        Puzzle puzzle(0, Sudoku(), Sudoku());
+        if(!context.cache->tryTake(level, puzzle)) {
+            puzzle = generatePuzzle(level, context.seed + context.generated++);
+        }
+
+        char id[17];
+        snprintf(id, sizeof(id), "%016llx", (unsigned long long) puzzle.id);
+
+        std::string response = "OK ";
+        puzzle.puzzle.writeString(board);
+        response.append(board, 81);
+        response += ' ';
+        puzzle.solution.writeString(board);
+        response.append(board, 81);
+        response += ' ';
+        response += id;
+        response += '\n';
+        return response;
+    }
+
+    if(command == "SOLVE") {
+        Sudoku sudoku;
+        if(!parseBoard(argument, sudoku)) return "ERR invalid\n";
+        SearchResult result = solver.solveBounded(sudoku, context.budget);
+        if(result == SEARCH_UNSOLVABLE) return "ERR unsolvable\n";
+        if(result == SEARCH_BUDGET) return "ERR budget\n";
+        if(result == SEARCH_CANCELLED) return "ERR cancelled\n";
+
+        sudoku.writeString(board);
+        return std::string("OK ") + board + "\n";
+    }
+
+    if(command == "VALIDATE") {
+        Sudoku sudoku;
+        if(!parseBoard(argument, sudoku)) return "ERR invalid\n";
+        if(!sudoku.isValid()) return "OK invalid\n";
+
+        int solutions;
+        SearchResult result = solver.countBounded(sudoku, 2, solutions, context.budget);
+        if(result == SEARCH_BUDGET) return "ERR budget\n";
+        if(result == SEARCH_CANCELLED) return "ERR cancelled\n";
+        if(solutions == 0) return "OK unsolvable\n";
+        return solutions == 1 ? "OK unique\n" : "OK multiple\n";
+    }
+
+    return "ERR unknown request\n";
+}
+
+/**
+ * --------------------------- SERVER ---------------------------
+*/
+
+struct Connection {
+    int fd;
+    uint64_t id;
+    std::string input;                  // Received, not yet a whole line
+    std::string output;                 // Responses not yet written
+    uint64_t nextSequence;              // Given to the next request
+    uint64_t nextReply;                 // Sequence of the next response to write
+    std::map <uint64_t, std::string> done;      // Responses that arrived before an earlier one
+    bool reading;                       // False once the peer shut down its side
+    bool writing;                       // Whether EPOLLOUT is requested
+    bool paused;                        // Not read until its backlog drains (see isBacklogged)
+    uint32_t events;                    // Currently watched
+};
+
+// A peer that keeps sending requests but never reads its responses would otherwise grow the
+// output and the responses waiting for an earlier one without bound
+static bool isBacklogged(const Connection *connection) {
+    return connection->output.size() >= MAX_OUTPUT || connection->nextSequence - connection->nextReply >= MAX_IN_FLIGHT;
+}
+
+class PuzzleServer {
+private:
+    int listenFd;
+    int epollFd;
+    int wakeFd;                         // eventfd, workers signal finished batches through it
+    int signalFd;
+    ThreadPool &pool;
+    ServerContext &context;
+    std::unordered_map <uint64_t, Connection*> connections;
+    uint64_t nextId;
+    std::vector <Request> batch;        // Requests read in this round, not yet submitted
+    std::mutex finishedLock;
+    std::vector <Response> finished;    // Filled by workers, drained by the event loop
+
+    void watch(int fd, uint32_t events, uint64_t key, int operation);
+    void updateEvents(Connection *connection);
+    void acceptConnections();
+    void readConnection(Connection *connection);
+    void writeConnection(Connection *connection);
+    void closeConnection(Connection *connection);
+    void submitBatch();
+    void submitTask(std::shared_ptr<std::vector<Request> > requests);
+    void collectResponses();
+public:
+    PuzzleServer(int listenFd, int signalFd, ThreadPool &pool, ServerContext &context);
+    ~PuzzleServer();
+    void run();
+};
+
+// epoll keys: the fixed descriptors use small keys, connections their id
+static const uint64_t KEY_LISTEN = 0;
+static const uint64_t KEY_WAKE = 1;
+static const uint64_t KEY_SIGNAL = 2;
+static const uint64_t FIRST_CONNECTION = 3;
+
+PuzzleServer::PuzzleServer(int listenFd, int signalFd, ThreadPool &pool, ServerContext &context) : pool(pool), context(context) {
+    this->listenFd = listenFd;
+    this->signalFd = signalFd;
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    this->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    this->nextId = FIRST_CONNECTION;
+
+    this->watch(this->listenFd, EPOLLIN, KEY_LISTEN, EPOLL_CTL_ADD);
+    this->watch(this->wakeFd, EPOLLIN, KEY_WAKE, EPOLL_CTL_ADD);
+    this->watch(this->signalFd, EPOLLIN, KEY_SIGNAL, EPOLL_CTL_ADD);
+}
+
+PuzzleServer::~PuzzleServer() {
+    // Workers may still post responses, let them finish before the descriptors go away
+    this->pool.wait();
+
+    while(!this->connections.empty()) {
+        this->closeConnection(this->connections.begin()->second);
+    }
+    close(this->wakeFd);
+    close(this->epollFd);
+}
+
+void PuzzleServer::watch(int fd, uint32_t events, uint64_t key, int operation) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.u64 = key;
+    epoll_ctl(this->epollFd, operation, fd, &event);
+}
+
+// Watches reading unless the peer is done sending or the connection is paused, writing while output is queued
+void PuzzleServer::updateEvents(Connection *connection) {
+    uint32_t events = 0;
+    if(connection->reading && !connection->paused) events |= (uint32_t) EPOLLIN | (uint32_t) EPOLLRDHUP;
+    if(connection->writing) events |= (uint32_t) EPOLLOUT;
+
+    if(events != connection->events) {
+        connection->events = events;
+        this->watch(connection->fd, events, connection->id, EPOLL_CTL_MOD);
+    }
+}
+
+void PuzzleServer::acceptConnections() {
+    while(1) {
+        int fd = accept4(this->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0) return;
+
+        Connection *connection = new Connection();
+        connection->fd = fd;
+        connection->id = this->nextId++;
+        connection->nextSequence = 0;
+        connection->nextReply = 0;
+        connection->reading = true;
+        connection->writing = false;
+        connection->paused = false;
+        connection->events = (uint32_t) EPOLLIN | (uint32_t) EPOLLRDHUP;
+
+        this->connections[connection->id] = connection;
+        this->watch(fd, connection->events, connection->id, EPOLL_CTL_ADD);
+    }
+}
+
+void PuzzleServer::readConnection(Connection *connection) {
+    char buffer[16384];
+
+    while(connection->reading && !connection->paused) {
+        ssize_t count = read(connection->fd, buffer, sizeof(buffer));
+        if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if(count < 0 && errno == EINTR) continue;
+        if(count <= 0) {
+            connection->reading = false;
+            break;
+        }
+
+        connection->input.append(buffer, count);
+
+        size_t start = 0, end;
+        while((end = connection->input.find('\n', start)) != std::string::npos) {
+            size_t length = end - start;
+            if(length > 0 && connection->input[end - 1] == '\r') length--;
+
+            if(length > 0) {
+                Request request;
+                request.connection = connection->id;
+                request.sequence = connection->nextSequence++;
+                request.line.assign(connection->input, start, length);
+                this->batch.push_back(request);
+
+                if(this->batch.size() >= (size_t) BATCH_REQUESTS) this->submitBatch();
+            }
+            start = end + 1;
+        }
+        connection->input.erase(0, start);
+
+        if(connection->input.size() > MAX_LINE) {
+            // Not a request of this protocol, answer what was asked so far and stop reading
+            connection->reading = false;
+        }
+
+        // Resumed by writeConnection once the peer took enough responses
+        if(isBacklogged(connection)) connection->paused = true;
+    }
+
+    this->updateEvents(connection);
+    if(!connection->reading && connection->nextReply == connection->nextSequence && connection->output.empty()) {
+        this->closeConnection(connection);
+    }
+}
+
+void PuzzleServer::writeConnection(Connection *connection) {
+    while(!connection->output.empty()) {
+        ssize_t count = send(connection->fd, connection->output.data(), connection->output.size(), MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR) continue;
+        if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if(count < 0) {
+            this->closeConnection(connection);
+            return;
+        }
+        connection->output.erase(0, count);
+    }
+
+    connection->writing = !connection->output.empty();
+    if(connection->paused && !isBacklogged(connection)) connection->paused = false;
+    this->updateEvents(connection);
+
+    // A peer that stopped sending is closed once every request got its response
+    if(!connection->reading && !connection->writing && connection->nextReply == connection->nextSequence) {
+        this->closeConnection(connection);
+    }
+}
+
+void PuzzleServer::closeConnection(Connection *connection) {
+    epoll_ctl(this->epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    this->connections.erase(connection->id);
+    delete connection;
+}
+
+// GEN can take a while when the cache is empty, so every GEN gets its own task
+// and the quick SOLVE / VALIDATE requests of the batch don't wait behind it
+void PuzzleServer::submitBatch() {
+    if(this->batch.empty()) return;
+
+    std::shared_ptr<std::vector<Request> > quick(new std::vector<Request>());
+    for(size_t i = 0; i < this->batch.size(); i++) {
+        if(this->batch[i].line.compare(0, 4, "GEN ") == 0) {
+            std::shared_ptr<std::vector<Request> > single(new std::vector<Request>(1, this->batch[i]));
+            this->submitTask(single);
+        } else {
+            quick->push_back(this->batch[i]);
+        }
+    }
+    this->batch.clear();
+
+    if(!quick->empty()) this->submitTask(quick);
+}
+
+void PuzzleServer::submitTask(std::shared_ptr<std::vector<Request> > requests) {
+    this->pool.submit([this, requests]() {
+        Solver &solver = *this->context.solvers[this->pool.getWorkerIndex()];
+        std::vector <Response> responses(requests->size());
+
+        for(size_t i = 0; i < requests->size(); i++) {
+            responses[i].connection = (*requests)[i].connection;
+            responses[i].sequence = (*requests)[i].sequence;
+            responses[i].text = handleRequest((*requests)[i].line, this->context, solver);
+        }
+
+        {
+            std::unique_lock<std::mutex> guard(this->finishedLock);
+            for(size_t i = 0; i < responses.size(); i++) {
+                this->finished.push_back(responses[i]);
+            }
+        }
+
+        uint64_t one = 1;
+        ssize_t ignored = write(this->wakeFd, &one, sizeof(one));
+        (void) ignored;
+    });
+}
+
+// Moves finished responses to their connections, in request order
+void PuzzleServer::collectResponses() {
+    uint64_t counter;
+    ssize_t ignored = read(this->wakeFd, &counter, sizeof(counter));
+    (void) ignored;
+
+    std::vector <Response> responses;
+    {
+        std::unique_lock<std::mutex> guard(this->finishedLock);
+        responses.swap(this->finished);
+    }
+
+    std::vector <Connection*> touched;
+    for(size_t i = 0; i < responses.size(); i++) {
+        std::unordered_map <uint64_t, Connection*>::iterator found = this->connections.find(responses[i].connection);
+        if(found == this->connections.end()) continue;     // Closed meanwhile
+
+        Connection *connection = found->second;
+        connection->done[responses[i].sequence].swap(responses[i].text);
+
+        std::map <uint64_t, std::string>::iterator next;
+        while((next = connection->done.find(connection->nextReply)) != connection->done.end()) {
+            connection->output += next->second;
+            connection->done.erase(next);
+            connection->nextReply++;
+        }
+        touched.push_back(connection);
+    }
+
+    for(size_t i = 0; i < touched.size(); i++) {
+        // The same connection can be listed more than once and be closed by the first write
+        if(this->connections.count(touched[i]->id) == 0) continue;
+        this->writeConnection(touched[i]);
+    }
+}
+
+void PuzzleServer::run() {
+    struct epoll_event events[MAX_EVENTS];
+
+    while(1) {
+        int count = epoll_wait(this->epollFd, events, MAX_EVENTS, -1);
+        if(count < 0 && errno == EINTR) continue;
+        if(count < 0) return;
+
+        for(int i = 0; i < count; i++) {
+            uint64_t key = events[i].data.u64;
+
+            if(key == KEY_SIGNAL) {
+                this->context.cancel.cancel();
+                return;
+            }
+            if(key == KEY_LISTEN) {
+                this->acceptConnections();
+                continue;
+            }
+            if(key == KEY_WAKE) {
+                this->collectResponses();
+                continue;
+            }
+
+            std::unordered_map <uint64_t, Connection*>::iterator found = this->connections.find(key);
+            if(found == this->connections.end()) continue;
+
+            Connection *connection = found->second;
+            if(events[i].events & (EPOLLHUP | EPOLLERR)) {
+                // Gone for good, responses couldn't be delivered anymore
+                this->closeConnection(connection);
+                continue;
+            }
+            if(events[i].events & EPOLLOUT) {
+                this->writeConnection(connection);
+                if(this->connections.count(key) == 0) continue;
+            }
+            if(events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                this->readConnection(connection);
+            }
+        }
+
+        // Everything read in this round goes out together
+        this->submitBatch();
+    }
+}
+
+// Only a socket nobody answers on is removed, anything else at the path is left alone
+static bool removeStaleSocket(const std::string &socketPath, const struct sockaddr_un &address) {
+    struct stat info;
+    if(lstat(socketPath.c_str(), &info) != 0) {
+        if(errno == ENOENT) return true;
+        fprintf(stderr, "Can't check %s: %s\n", socketPath.c_str(), strerror(errno));
+        return false;
+    }
+
+    if(!S_ISSOCK(info.st_mode)) {
+        fprintf(stderr, "%s exists and isn't a socket\n", socketPath.c_str());
+        return false;
+    }
+
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(probe < 0) {
+        fprintf(stderr, "Can't check %s: %s\n", socketPath.c_str(), strerror(errno));
+        return false;
+    }
+    bool answered = connect(probe, (const struct sockaddr*) &address, sizeof(address)) == 0;
+    int error = errno;
+    close(probe);
+
+    if(answered) {
+        fprintf(stderr, "A server is already listening on %s\n", socketPath.c_str());
+        return false;
+    }
+    if(error != ECONNREFUSED) {
+        fprintf(stderr, "Can't check %s: %s\n", socketPath.c_str(), strerror(error));
+        return false;
+    }
+
+    unlink(socketPath.c_str());
+    return true;
+}
+
+int runServer(const std::string &socketPath, int threads, const std::string &solverName, uint64_t seed, const SearchBudget &budget) {
+    Solver *check = createSolver(solverName);
+    if(check == NULL) {
+        fprintf(stderr, "Unknown solver: %s\n", solverName.c_str());
+        return 1;
+    }
+    bool bounded = check->isBounded();
+    delete check;
+
+    if((budget.nodes > 0 || budget.ms > 0) && !bounded) {
+        fprintf(stderr, "--budget-nodes and --budget-ms need --solver iterative or parallel\n");
+        return 1;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socketPath.c_str());
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    if(!removeStaleSocket(socketPath, address)) return 1;
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(listenFd < 0 || bind(listenFd, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(listenFd, 128) != 0) {
+        fprintf(stderr, "Can't listen on %s: %s\n", socketPath.c_str(), strerror(errno));
+        if(listenFd >= 0) close(listenFd);
+        return 1;
+    }
+
+    // Blocked before any thread starts, so only the signalfd ever sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    int signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    ServerContext context;
+    context.seed = seed;
+    context.generated = 0;
+    context.budget = budget;
+    context.budget.cancel = &context.cancel;
+    context.cache = new PuzzleQueue(CACHE_PER_LEVEL, seed, NULL);
+
+    {
+        ThreadPool pool(threads);
+        for(int i = 0; i < pool.getSize(); i++) {
+            context.solvers.push_back(createSolver(solverName));
+        }
+
+        fprintf(stderr, "Serving on %s (%d threads, %s)\n", socketPath.c_str(), pool.getSize(), solverName.c_str());
+
+        PuzzleServer server(listenFd, signalFd, pool, context);
+        server.run();
+    }
+
+    delete context.cache;
+    for(size_t i = 0; i < context.solvers.size(); i++) {
+        delete context.solvers[i];
+    }
+
+    close(signalFd);
+    close(listenFd);
+    unlink(socketPath.c_str());
+    fprintf(stderr, "Server stopped\n");
+    return 0;
+}
+
+/**
+ * --------------------------- LOAD TEST ---------------------------
+*/
+
+enum RequestKind { GEN, SOLVE, VALIDATE, KINDS };
+
+static const char *KIND_NAMES[KINDS] = { "gen", "solve", "validate" };
+
+struct LoadResult {
+    std::vector <double> latencies[KINDS];     // ms
+    long errors;
+};
+
+static int connectTo(const std::string &socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0) return -1;
+    if(connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const std::string &data) {
+    size_t sent = 0;
+    while(sent < data.size()) {
+        ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR) continue;
+        if(count <= 0) return false;
+        sent += count;
+    }
+    return true;
+}
+
+// Request number index of the mix: GEN, SOLVE and VALIDATE take turns, levels and puzzles rotate
+static RequestKind requestKind(long index) {
+    return (RequestKind) (index % KINDS);
+}
+
+static std::string requestLine(long index, const std::vector <std::string> &corpus) {
+    long turn = index / KINDS;
+    switch(requestKind(index)) {
+        case GEN:
+            return std::string("GEN ") + (char) ('0' + turn % 3) + "\n";
+        case SOLVE:
+            return "SOLVE " + corpus[turn % corpus.size()] + "\n";
+        default:
+            return "VALIDATE " + corpus[turn % corpus.size()] + "\n";
+    }
+}
+
+// Runs requests first .. first + count - 1 on one connection, keeping up to pipeline of them in flight
+static void loadConnection(const std::string &socketPath, const std::vector <std::string> &corpus,
+        long first, long count, int pipeline, LoadResult &result) {
+    typedef std::chrono::steady_clock Clock;
+
+    result.errors = 0;
+    int fd = connectTo(socketPath);
+    if(fd < 0) {
+        result.errors = count;
+        return;
+    }
+
+    std::vector <Clock::time_point> sentAt(count);
+    std::string pending;
+    long sent = 0, received = 0;
+    char buffer[16384];
+
+    while(received < count) {
+        std::string requests;
+        while(sent < count && sent - received < pipeline) {
+            requests += requestLine(first + sent, corpus);
+            sentAt[sent++] = Clock::now();
+        }
+        if(!requests.empty() && !sendAll(fd, requests)) break;
+
+        ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if(length < 0 && errno == EINTR) continue;
+        if(length <= 0) break;
+
+        pending.append(buffer, length);
+        size_t start = 0, end;
+        while((end = pending.find('\n', start)) != std::string::npos) {
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - sentAt[received]).count();
+            result.latencies[requestKind(first + received)].push_back(ms);
+            if(pending.compare(start, 3, "OK ") != 0) result.errors++;
+
+            received++;
+            start = end + 1;
+        }
+        pending.erase(0, start);
+    }
+
+    result.errors += count - received;
+    close(fd);
+}
+
+static void writeLatencies(std::vector <double> &latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    double p50 = 0, p99 = 0, max = 0;
+    if(!latencies.empty()) {
+        p50 = latencies[(size_t) (0.50 * (latencies.size() - 1))];
+        p99 = latencies[(size_t) (0.99 * (latencies.size() - 1))];
+        max = latencies.back();
+    }
+    printf("\"requests\":%zu,\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f", latencies.size(), p50, p99, max);
+}
+
+int runLoadTest(const std::string &socketPath, long count, int connections, int pipeline) {
+    if(connections < 1) connections = 1;
+    if(pipeline < 1) pipeline = 1;
+
+    // Puzzles to solve and validate come from the server itself
+    std::vector <std::string> corpus;
+    int fd = connectTo(socketPath);
+    if(fd < 0) {
+        fprintf(stderr, "Can't connect to %s\n", socketPath.c_str());
+        return 1;
+    }
+
+    std::string warmUp;
+    for(int i = 0; i < 9; i++) {
+        warmUp += std::string("GEN ") + (char) ('0' + i % 3) + "\n";
+    }
+    sendAll(fd, warmUp);
+
+    std::string pending;
+    char buffer[4096];
+    while(corpus.size() < 9) {
+        ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if(length <= 0) break;
+        pending.append(buffer, length);
+
+        size_t end;
+        while((end = pending.find('\n')) != std::string::npos) {
+            if(pending.compare(0, 3, "OK ") == 0 && end >= 84) corpus.push_back(pending.substr(3, 81));
+            pending.erase(0, end + 1);
+        }
+    }
+    close(fd);
+
+    if(corpus.empty()) {
+        fprintf(stderr, "The server didn't generate any puzzles\n");
+        return 1;
+    }
+
+    std::vector <LoadResult> results(connections);
+    std::vector <std::thread> threads;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long first = 0;
+    for(int i = 0; i < connections; i++) {
+        long share = count / connections + (i < count % connections ? 1 : 0);
+        threads.push_back(std::thread(loadConnection, std::cref(socketPath), std::cref(corpus),
+            first, share, pipeline, std::ref(results[i])));
+        first += share;
+    }
+    for(size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector <double> all;
+    std::vector <double> kinds[KINDS];
+    long errors = 0;
+    for(int i = 0; i < connections; i++) {
+        errors += results[i].errors;
+        for(int kind = 0; kind < KINDS; kind++) {
+            kinds[kind].insert(kinds[kind].end(), results[i].latencies[kind].begin(), results[i].latencies[kind].end());
+            all.insert(all.end(), results[i].latencies[kind].begin(), results[i].latencies[kind].end());
+        }
+    }
+
+    printf("{\"connections\":%d,\"pipeline\":%d,\"seconds\":%.3f,\"throughput\":%.1f,\"errors\":%ld,",
+        connections, pipeline, seconds, seconds > 0 ? all.size() / seconds : 0.0, errors);
+    writeLatencies(all);
+    for(int kind = 0; kind < KINDS; kind++) {
+        printf(",\"%s\":{", KIND_NAMES[kind]);
+        writeLatencies(kinds[kind]);
+        printf("}");
+    }
+    printf("}\n");
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+#include "../headers/session.h"
+#include "../headers/bank.h"
+#include "../headers/renderer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const uint32_t SESSION_VERSION = 1;
+static const size_t FLUSH_BYTES = 1 << 16;     // Recorded events kept in memory before writing them
+static const size_t MAX_DELAY_BYTES = 10;       // LEB128 bytes of a 64-bit key delay
+
+static FILE *recording = NULL;
+static std::vector <unsigned char> events;     // Not yet written events, or the whole replayed log
+static size_t replayPosition = 0;
+static bool replaying = false;
+static std::vector <Puzzle> replayPuzzles;       // Every puzzle of the replayed log, made up front
+static size_t nextPuzzle = 0;
+
+static std::chrono::steady_clock::time_point lastKey;
+static long keys = 0;
+static long games = 0;
+static uint64_t recordedMs = 0;                 // Sum of the logged key delays
+
+static std::chrono::steady_clock::time_point replayStart;
+
+bool startRecording(const std::string &path, int lines, int columns, bool animate) {
+    recording = fopen(path.c_str(), "wb");
+    if(recording == NULL) {
+        fprintf(stderr, "Can't create %s\n", path.c_str());
+        return false;
+    }
+
+    SessionHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "SDKS", 4);
+    header.version = SESSION_VERSION;
+    header.lines = lines;
+    header.columns = columns;
+    header.flags = animate ? SESSION_ANIMATE : 0;
+
+    const char *term = getenv("TERM");
+    if(term != NULL) strncpy(header.term, term, sizeof(header.term) - 1);
+
+    fwrite(&header, sizeof(header), 1, recording);
+    lastKey = std::chrono::steady_clock::now();
+    return true;
+}
+
+// Bytes of the event at position after its tag, 0 when the log ends in the middle of it
+static size_t getEventSize(size_t position) {
+    char tag = events[position];
+    size_t size = 0;
+    if(tag == 'p') size = sizeof(uint64_t);
+    if(tag == 'b') size = 81;
+    if(tag == 'k') {
+        // LEB128 delay, then the key
+        size_t end = position + 1;
+        while(end < events.size() && (events[end] & 0x80)) end++;
+        if(end - position > MAX_DELAY_BYTES) return 0;
+        size = end + 1 + sizeof(int16_t) - (position + 1);
+    }
+
+    return position + 1 + size <= events.size() ? size : 0;
+}
+
+// Checks every event and makes the puzzles, so generating them doesn't count into any frame
+static bool loadReplayPuzzles() {
+    for(size_t position = 0; position < events.size(); ) {
+        size_t size = getEventSize(position);
+        if(size == 0) return false;
+
+        if(events[position] == 'p') {
+            uint64_t id;
+            memcpy(&id, &events[position + 1], sizeof(id));
+            replayPuzzles.push_back(regeneratePuzzle(id));
+        }
+        if(events[position] == 'b') {
+            if(!isValidBankEntry(&events[position + 1])) return false;
+            replayPuzzles.push_back(decodeBankEntry(&events[position + 1]));
+        }
+
+        position += 1 + size;
+    }
+    return true;
+}
+
+bool startReplay(const std::string &path, SessionHeader &header) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if(file == NULL) {
+        fprintf(stderr, "Can't open %s\n", path.c_str());
+        return false;
+    }
+
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+        && memcmp(header.magic, "SDKS", 4) == 0
+        && header.version == SESSION_VERSION;
+    header.term[sizeof(header.term) - 1] = '\0';
+
+    unsigned char block[4096];
+    size_t count;
+    while(valid && (count = fread(block, 1, sizeof(block), file)) > 0) {
+        events.insert(events.end(), block, block + count);
+    }
+    fclose(file);
+
+    if(!valid || !loadReplayPuzzles()) {
+        fprintf(stderr, "%s is not a recorded session\n", path.c_str());
+        return false;
+    }
+
+    replaying = true;
+    replayStart = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool isReplaying() {
+    return replaying;
+}
+
+static void flushEvents() {
+    if(recording == NULL || events.empty()) return;
+    fwrite(&events[0], 1, events.size(), recording);
+    events.clear();
+}
+
+void finishSession() {
+    if(recording == NULL) return;
+    flushEvents();
+    fclose(recording);
+    recording = NULL;
+}
+
+static void appendBytes(const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char*) data;
+    events.insert(events.end(), bytes, bytes + size);
+}
+
+static void readBytes(void *data, size_t size) {
+    memcpy(data, &events[replayPosition], size);
+    replayPosition += size;
+}
+
+// A replay can't go on without the next event, ends it with what was measured so far
+static void endReplay(const char *reason) {
+    endwin();
+    fprintf(stderr, "Replay stopped: %s\n", reason);
+    writeReplayReport(stdout);
+    exit(0);
+}
+
+// Returns the tag of the next logged event, startReplay() made sure the whole event is there
+static char nextEvent() {
+    if(replayPosition >= events.size()) endReplay("the session log ends before the session does");
+    return events[replayPosition++];
+}
+
+void recordPuzzle(Puzzle &puzzle) {
+    games++;
+    if(recording == NULL) return;
+
+    if(puzzle.id != 0) {
+        events.push_back('p');
+        appendBytes(&puzzle.id, sizeof(puzzle.id));
+    } else {
+        unsigned char entry[81];
+        encodeBankEntry(puzzle, entry);
+        events.push_back('b');
+        appendBytes(entry, sizeof(entry));
+    }
+}
+
+Puzzle replayPuzzle() {
+    games++;
+    char tag = nextEvent();
+    if(tag != 'p' && tag != 'b') endReplay("the session log has a key where a new game should start");
+
+    replayPosition += getEventSize(replayPosition - 1);
+    return replayPuzzles[nextPuzzle++];
+}
+
+static FramePath getFramePath(int key, bool inGame) {
+    if(!inGame) return MENU_FRAME;
+    if(key == ERR) return TICK_FRAME;
+    if(key == 'w' || key == 'a' || key == 's' || key == 'd') return NAVIGATION_FRAME;
+    if((key >= '1' && key <= '9') || key == 'u' || key == 'r') return ENTRY_FRAME;
+    return MENU_FRAME;
+}
+
+int readKey(WINDOW *window, bool inGame) {
+    // wgetch() would refresh a changed window before waiting, done here so the frame includes it
+    if(is_wintouched(window)) wrefresh(window);
+    finishFrame();
+
+    int key;
+    if(replaying) {
+        if(nextEvent() != 'k') endReplay("the session log starts a new game where a key should be");
+
+        uint64_t ms = 0;
+        int shift = 0;
+        unsigned char byte;
+        // startReplay() made sure the delay fits MAX_DELAY_BYTES, bits past 64 are dropped
+        do {
+            readBytes(&byte, 1);
+            if(shift < 64) ms |= (uint64_t) (byte & 0x7F) << shift;
+            shift += 7;
+        } while(byte & 0x80);
+
+        int16_t logged;
+        readBytes(&logged, sizeof(logged));
+        key = logged;
+        recordedMs += ms;
+    } else {
+        // Written between frames, so the log doesn't count as terminal output
+        if(events.size() >= FLUSH_BYTES) flushEvents();
+
+        key = wgetch(window);
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastKey).count();
+        lastKey = now;
+        recordedMs += ms;
+
+        if(recording != NULL) {
+            events.push_back('k');
+            do {
+                events.push_back((ms & 0x7F) | (ms >= 0x80 ? 0x80 : 0));
+                ms >>= 7;
+            } while(ms > 0);
+
+            int16_t logged = key;
+            appendBytes(&logged, sizeof(logged));
+        }
+    }
+
+    keys++;
+    beginFrame(getFramePath(key, inGame));
+    return key;
+}
+
+void writeReplayReport(FILE *output) {
+    finishFrame();
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - replayStart).count();
+    fprintf(output, "{\"keys\":%ld,\"games\":%ld,\"recordedMs\":%llu,\"replayMs\":%.3f,\"frames\":",
+        keys, games, (unsigned long long) recordedMs, ms);
+    writeRenderStatsJson(output);
+    fprintf(output, "}\n");
+}
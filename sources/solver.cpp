@@ -0,0 +1,38 @@
+#include "../headers/solver.h"
+#include "../headers/dlx.h"
+#include "../headers/iterative.h"
+#include "../headers/parallel.h"
+
+SearchResult Solver::solveBounded(Sudoku &sudoku, const SearchBudget &) {
+    return this->solve(sudoku) ? SEARCH_SOLVED : SEARCH_UNSOLVABLE;
+}
+
+int Solver::countSolutions(Sudoku &sudoku, int limit) {
+    return sudoku.countSolutions(limit);
+}
+
+SearchResult Solver::countBounded(Sudoku &sudoku, int limit, int &solutions, const SearchBudget &) {
+    solutions = this->countSolutions(sudoku, limit);
+    return SEARCH_SOLVED;
+}
+
+bool Solver::isBounded() {
+    return false;
+}
+
+const char* BacktrackingSolver::getName() {
+    return "backtracking";
+}
+
+bool BacktrackingSolver::solve(Sudoku &sudoku) {
+    return sudoku.solveSudoku(0, 0);
+}
+
+Solver* createSolver(const std::string &name) {
+    if(name == "backtracking") return new BacktrackingSolver();
+    if(name == "dlx") return new DlxSolver();
+    if(name == "iterative") return new IterativeSolver();
+    if(name == "parallel") return new ParallelSolver();
+
+    return NULL;
+}
@@ -0,0 +1,105 @@
+#include "../headers/stats.h"
+#include <algorithm>
+#include <cstring>
+
+thread_local Counters threadCounters;
+
+Counters takeCounters() {
+    Counters counters = threadCounters;
+    memset(&threadCounters, 0, sizeof(threadCounters));
+    return counters;
+}
+
+static void addCounters(Counters &total, const Counters &counters) {
+    total.nodes += counters.nodes;
+    total.backtracks += counters.backtracks;
+    total.maxDepth = std::max(total.maxDepth, counters.maxDepth);
+    total.isSafeCalls += counters.isSafeCalls;
+    total.propagated += counters.propagated;
+    total.gridAttempts += counters.gridAttempts;
+    total.removalAttempts += counters.removalAttempts;
+    total.removals += counters.removals;
+    total.grades += counters.grades;
+}
+
+void mergeCounters(const Counters &counters) {
+    addCounters(threadCounters, counters);
+}
+
+static void writeCounters(FILE *output, const Counters &counters) {
+    fprintf(output, "\"nodes\":%llu,\"backtracks\":%llu,\"maxDepth\":%llu,\"isSafeCalls\":%llu,\"propagated\":%llu,"
+        "\"gridAttempts\":%llu,\"removalAttempts\":%llu,\"removals\":%llu,\"grades\":%llu",
+        (unsigned long long) counters.nodes, (unsigned long long) counters.backtracks,
+        (unsigned long long) counters.maxDepth, (unsigned long long) counters.isSafeCalls,
+        (unsigned long long) counters.propagated, (unsigned long long) counters.gridAttempts,
+        (unsigned long long) counters.removalAttempts, (unsigned long long) counters.removals,
+        (unsigned long long) counters.grades);
+}
+
+// Latency below which p percent of the puzzles stay, latencies has to be sorted
+static double percentile(const std::vector <double> &latencies, double p) {
+    if(latencies.empty()) return 0;
+    size_t index = (size_t) (p / 100 * (latencies.size() - 1) + 0.5);
+    return latencies[index];
+}
+
+StatsReport::StatsReport(FILE *json) {
+    this->json = json;
+    memset(&this->total, 0, sizeof(this->total));
+    memset(&this->slowest, 0, sizeof(this->slowest));
+    this->slowest.index = -1;
+}
+
+void StatsReport::add(const PuzzleStats &puzzle) {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    this->latencies.push_back(puzzle.ms);
+    addCounters(this->total, puzzle.counters);
+    if(this->slowest.index < 0 || puzzle.ms > this->slowest.ms) this->slowest = puzzle;
+
+    if(this->json != NULL) {
+        fprintf(this->json, "{\"index\":%ld,\"id\":\"%016llx\",\"ms\":%.3f,", puzzle.index, (unsigned long long) puzzle.id, puzzle.ms);
+        writeCounters(this->json, puzzle.counters);
+        fprintf(this->json, "}\n");
+    }
+}
+
+void StatsReport::printSummary(FILE *output, const char *title) {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    std::vector <double> sorted = this->latencies;
+    std::sort(sorted.begin(), sorted.end());
+    size_t count = sorted.size();
+
+    fprintf(output, "%s: %zu puzzles\n", title, count);
+    if(count == 0) return;
+
+    fprintf(output, "  latency ms     p50 %.3f  p99 %.3f  max %.3f\n",
+        percentile(sorted, 50), percentile(sorted, 99), sorted[count - 1]);
+    fprintf(output, "  nodes          %llu (%.1f per puzzle), %llu backtracks, max depth %llu\n",
+        (unsigned long long) this->total.nodes, (double) this->total.nodes / count,
+        (unsigned long long) this->total.backtracks, (unsigned long long) this->total.maxDepth);
+    fprintf(output, "  isSafe calls   %llu, %llu cells propagated\n",
+        (unsigned long long) this->total.isSafeCalls, (unsigned long long) this->total.propagated);
+    fprintf(output, "  generation     %llu grids, %llu of %llu clue removals, %llu grades\n",
+        (unsigned long long) this->total.gridAttempts, (unsigned long long) this->total.removals,
+        (unsigned long long) this->total.removalAttempts, (unsigned long long) this->total.grades);
+    fprintf(output, "  slowest        #%ld id %016llx, %.3f ms, %llu nodes\n",
+        this->slowest.index, (unsigned long long) this->slowest.id, this->slowest.ms,
+        (unsigned long long) this->slowest.counters.nodes);
+}
+
+void StatsReport::writeSummaryJson(const char *title) {
+    std::unique_lock<std::mutex> guard(this->lock);
+    if(this->json == NULL) return;
+
+    std::vector <double> sorted = this->latencies;
+    std::sort(sorted.begin(), sorted.end());
+
+    fprintf(this->json, "{\"summary\":\"%s\",\"puzzles\":%zu,\"p50\":%.3f,\"p99\":%.3f,\"max\":%.3f,\"slowest\":%ld,",
+        title, sorted.size(), percentile(sorted, 50), percentile(sorted, 99),
+        sorted.empty() ? 0.0 : sorted.back(), this->slowest.index);
+    writeCounters(this->json, this->total);
+    fprintf(this->json, "}\n");
+    fflush(this->json);
+}
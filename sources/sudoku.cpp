@@ -1,31 +1,84 @@
 #include "../headers/sudoku.h"
+#include "../headers/propagate.h"
+#include "../headers/stats.h"
 #include <iostream>
 #include <algorithm>
-#include <ctime>
 
-Sudoku::Sudoku() {
-    for(int i = 1; i < 10; i++) { this->numbers.push_back(i); }
-    this->createSeed();
+template <int BoxN>
+BasicSudoku<BoxN>::BasicSudoku() {
+    this->clearBoard();
 }
 
-Sudoku::Sudoku(int grid[9][9]) {
-    for(int i = 0; i < 9; i++) {
-        for(int j = 0; j < 9; j++) {
-            this->sudokuArr[i][j] = grid[i][j];
+template <int BoxN>
+BasicSudoku<BoxN>::BasicSudoku(int grid[SIZE][SIZE]) {
+    this->clearBoard();
+    for(int i = 0; i < SIZE; i++) {
+        for(int j = 0; j < SIZE; j++) {
+            this->setItem(i, j, grid[i][j]);
         }
     }
 }
 
-void Sudoku::printSudoku() {
-    for(int i = 0; i < 9; i++) {
-        for(int j = 0; j < 9; j++) {
-            std::cout << this->sudokuArr[i][j] << " ";
+template <int BoxN>
+void BasicSudoku<BoxN>::clearBoard() {
+    this->searchNodes = 0;
+    for(int i = 0; i < SIZE; i++) {
+        for(int j = 0; j < SIZE; j++) {
+            this->sudokuArr[i][j] = 0;
+        }
+        this->rowMask[i] = 0;
+        this->colMask[i] = 0;
+        this->boxMask[i] = 0;
+    }
+}
+
+template <int BoxN>
+void BasicSudoku<BoxN>::printSudoku() {
+    for(int i = 0; i < SIZE; i++) {
+        for(int j = 0; j < SIZE; j++) {
+            std::cout << (int) this->sudokuArr[i][j] << " ";
         }
         std::cout << std::endl;
     }
 }
 
-int Sudoku::getItem(int x, int y) {
+// Reads CELLS characters row by row: 1-9 and A-P (10-25) for clues, 0 or . for blank fields
+template <int BoxN>
+bool BasicSudoku<BoxN>::loadString(const char *text) {
+    this->clearBoard();
+
+    for(int i = 0; i < CELLS; i++) {
+        char c = text[i];
+        int number = -1;
+
+        if(c >= '1' && c <= '9') number = c - '0';
+        if(c >= 'A' && c <= 'P') number = c - 'A' + 10;
+        if(c == '0' || c == '.') number = 0;
+
+        if(number < 0 || number > SIZE) return false;
+        if(number > 0) this->setItem(i / SIZE, i % SIZE, number);
+    }
+
+    return true;
+}
+
+// Writes the board as CELLS characters (0 for blank fields), without a terminating null
+template <int BoxN>
+void BasicSudoku<BoxN>::writeString(char *text) {
+    for(int i = 0; i < CELLS; i++) {
+        int number = this->sudokuArr[i / SIZE][i % SIZE];
+        text[i] = number < 10 ? '0' + number : 'A' + number - 10;
+    }
+}
+
+// Numbers tried by the last solveSudoku / countSolutions call
+template <int BoxN>
+long BasicSudoku<BoxN>::getSearchNodes() {
+    return this->searchNodes;
+}
+
+template <int BoxN>
+int BasicSudoku<BoxN>::getItem(int x, int y) const {
     return this->sudokuArr[x][y];
 }
 
@@ -36,86 +89,271 @@ int Sudoku::getItem(int x, int y) {
 */
 
 // Checks if it's legal to assign number to the given row and column
-bool Sudoku::isSafe(int row, int col, int number) {
-    // If we find the same number in row, we return false (not safe)
-    for (int i = 0; i < 9; i++) {
-        if(this->sudokuArr[row][i] == number) return false;
-    }
+template <int BoxN>
+bool BasicSudoku<BoxN>::isSafe(int row, int col, int number) {
+    STATS_ADD(isSafeCalls, 1);
 
-    // Same as the above but for columns
-    for (int i = 0; i < 9; i++) {
-        if(this->sudokuArr[i][col] == number) return false;
-    }
+    // Row, column and box masks already hold every number used in them
+    Mask used = this->rowMask[row] | this->colMask[col] | this->boxMask[boxIndex(row, col)];
+    return (used & ((Mask) 1 << (number - 1))) == 0;
+}
+
+// Solver-only assignment, the cell has to be empty and the number safe
+template <int BoxN>
+void BasicSudoku<BoxN>::placeNumber(int row, int col, int number) {
+    Mask bit = (Mask) 1 << (number - 1);
+    this->sudokuArr[row][col] = number;
+    this->rowMask[row] |= bit;
+    this->colMask[col] |= bit;
+    this->boxMask[boxIndex(row, col)] |= bit;
+}
+
+template <int BoxN>
+void BasicSudoku<BoxN>::removeNumber(int row, int col) {
+    Mask bit = (Mask) 1 << (this->sudokuArr[row][col] - 1);
+    this->sudokuArr[row][col] = 0;
+    this->rowMask[row] &= ~bit;
+    this->colMask[col] &= ~bit;
+    this->boxMask[boxIndex(row, col)] &= ~bit;
+}
+
+// Finds the empty cell with the fewest candidates and stores them in candidates.
+// Returns 1 when found, 0 when the board is full and -1 when some cell has no candidates left
+template <int BoxN>
+int BasicSudoku<BoxN>::findConstrainedCell(int &row, int &col, Mask &candidates) {
+    int best = SIZE + 1;
 
-    int startRow = row - row % 3;
-    int startCol = col - col % 3;
+    for(int i = 0; i < SIZE; i++) {
+        for(int j = 0; j < SIZE; j++) {
+            if(this->sudokuArr[i][j] > 0) continue;
 
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
-            if(this->sudokuArr[i + startRow][j + startCol] == number) return false;
+            Mask used = this->rowMask[i] | this->colMask[j] | this->boxMask[boxIndex(i, j)];
+            int count = SIZE - __builtin_popcount(used);
+
+            if(count < best) {
+                best = count;
+                row = i;
+                col = j;
+                candidates = ~used & ALL;
+                if(count <= 1) return count == 0 ? -1 : 1;
+            }
         }
     }
 
-    return true;
+    if(best == SIZE + 1) return 0;
+
+    // Past 9x9 the cell-based choice alone leaves the search tree far too wide,
+    // a number that fits only one cell of some unit is forced just like a single candidate
+    if(BoxN > 3) return this->findHiddenSingle(row, col, candidates);
+
+    return 1;
 }
 
-bool Sudoku::solveSudoku(int row, int col) {
-    if(row == 8 && col == 9) return true;
+// Looks for a unit where some missing number fits a single cell. Returns -1 when a missing
+// number fits nowhere, otherwise 1 (row, col and candidates are only changed when a single is found)
+template <int BoxN>
+int BasicSudoku<BoxN>::findHiddenSingle(int &row, int &col, Mask &candidates) {
+    for(int unit = 0; unit < 3 * SIZE; unit++) {
+        int kind = unit / SIZE, index = unit % SIZE;
+        Mask once = 0, twice = 0;
+        Mask missing = ALL & ~(kind == 0 ? this->rowMask[index] : kind == 1 ? this->colMask[index] : this->boxMask[index]);
 
-    if(col == 9) {
-        row++;
-        col = 0;
-    }
+        if(missing == 0) continue;
 
-    if(this->sudokuArr[row][col] > 0) return solveSudoku(row, col + 1);
+        for(int k = 0; k < SIZE; k++) {
+            int i = kind == 0 ? index : kind == 1 ? k : index - index % BoxN + k / BoxN;
+            int j = kind == 0 ? k : kind == 1 ? index : index % BoxN * BoxN + k % BoxN;
+            if(this->sudokuArr[i][j] > 0) continue;
 
-    for(int i = 1; i <= 9; i++) {
-        if(isSafe(row, col, i)) {
-            this->sudokuArr[row][col] = i;
-            
-            if(solveSudoku(row, col + 1)) {
-                return true;
+            Mask fits = ~(this->rowMask[i] | this->colMask[j] | this->boxMask[boxIndex(i, j)]) & ALL;
+            twice |= once & fits;
+            once |= fits;
+        }
+
+        if(missing & ~once) return -1;
+
+        Mask single = once & ~twice;
+        if(single == 0) continue;
+
+        single &= -single;
+        for(int k = 0; k < SIZE; k++) {
+            int i = kind == 0 ? index : kind == 1 ? k : index - index % BoxN + k / BoxN;
+            int j = kind == 0 ? k : kind == 1 ? index : index % BoxN * BoxN + k % BoxN;
+            if(this->sudokuArr[i][j] > 0) continue;
+
+            Mask fits = ~(this->rowMask[i] | this->colMask[j] | this->boxMask[boxIndex(i, j)]) & ALL;
+            if(fits & single) {
+                row = i;
+                col = j;
+                candidates = single;
+                return 1;
             }
         }
+    }
 
-        this->sudokuArr[row][col] = 0;
+    return 1;
+}
+
+template <int BoxN>
+bool BasicSudoku<BoxN>::solveConstrained(int depth) {
+    int row, col;
+    Mask candidates;
+    int found = this->findConstrainedCell(row, col, candidates);
+
+    if(found == 0) return true;
+    if(found < 0) return false;
+
+    STATS_MAX(maxDepth, depth + 1);
+
+    while(candidates) {
+        int number = __builtin_ctz(candidates) + 1;
+        candidates &= candidates - 1;
+
+        this->placeNumber(row, col, number);
+        this->searchNodes++;
+        STATS_ADD(nodes, 1);
+        if(this->solveConstrained(depth + 1)) return true;
+        this->removeNumber(row, col);
+        STATS_ADD(backtracks, 1);
     }
 
     return false;
 }
 
-void Sudoku::setItem(int x, int y, int number) {
-    this->sudokuArr[x][y] = number;
+// True when no number repeats within a row, column or box
+template <int BoxN>
+bool BasicSudoku<BoxN>::isValid() {
+    Mask rows[SIZE] = {0}, cols[SIZE] = {0}, boxes[SIZE] = {0};
+
+    for(int i = 0; i < SIZE; i++) {
+        for(int j = 0; j < SIZE; j++) {
+            if(this->sudokuArr[i][j] == 0) continue;
+
+            Mask bit = (Mask) 1 << (this->sudokuArr[i][j] - 1);
+            if((rows[i] | cols[j] | boxes[boxIndex(i, j)]) & bit) return false;
+
+            rows[i] |= bit;
+            cols[j] |= bit;
+            boxes[boxIndex(i, j)] |= bit;
+        }
+    }
+
+    return true;
 }
 
-/**
- * 
- * --------------------- SUDOKU GENERATOR FUNCTIONS ---------------------
- * 
-*/
+// Constraint propagation kernels only exist for the 9x9 board
+static int propagate(BasicSudoku<3> &sudoku) {
+    return propagateSingles(sudoku);
+}
+
+template <int BoxN>
+static int propagate(BasicSudoku<BoxN> &) {
+    return 0;
+}
+
+// row and col are kept for compatibility, the search always picks the most constrained empty cell first
+template <int BoxN>
+bool BasicSudoku<BoxN>::solveSudoku(int, int) {
+    // Conflicting givens would otherwise make the search exhaust the whole tree
+    if(!this->isValid()) return false;
+
+    this->searchNodes = 0;
+
+    // Singles are filled without branching, the search only handles what is left
+    int filled = propagate(*this);
+    if(filled < 0) return false;
+    STATS_ADD(propagated, filled);
 
-int getRandom(int limit) {
-    return rand()%limit;
+    return this->solveConstrained(0);
 }
 
-void Sudoku::createSeed() {
-    // Filling random fields with random numbers
+// Counts solutions of the current board, stopping as soon as limit is reached.
+// The board is left unchanged
+template <int BoxN>
+int BasicSudoku<BoxN>::countSolutions(int limit) {
+    this->searchNodes = 0;
+    if(!this->isValid()) return 0;
 
-    srand((unsigned int) time (NULL));
-    for(int i = 0; i < 3; i++) {
-        int randomRow = rand()%9;
-        // srand((unsigned int) time (NULL));
-        int randomCol = rand()%9;
-        // srand((unsigned int) time (NULL));
-        int randomNumber = rand()%9 + 1;
-        this->sudokuArr[randomRow][randomCol] = randomNumber;
+    int count = 0;
+    this->countConstrained(count, limit, 0);
+    return count;
+}
+
+template <int BoxN>
+void BasicSudoku<BoxN>::countConstrained(int &count, int limit, int depth) {
+    int row, col;
+    Mask candidates;
+    int found = this->findConstrainedCell(row, col, candidates);
+
+    if(found == 0) {
+        count++;
+        return;
+    }
+    if(found < 0) return;
+
+    STATS_MAX(maxDepth, depth + 1);
+
+    while(candidates && count < limit) {
+        int number = __builtin_ctz(candidates) + 1;
+        candidates &= candidates - 1;
+
+        this->placeNumber(row, col, number);
+        this->searchNodes++;
+        STATS_ADD(nodes, 1);
+        this->countConstrained(count, limit, depth + 1);
+        this->removeNumber(row, col);
+        STATS_ADD(backtracks, 1);
     }
 }
 
-int Sudoku::countBlank() {
+template <int BoxN>
+void BasicSudoku<BoxN>::setItem(int x, int y, int number) {
+    int previous = this->sudokuArr[x][y];
+    this->sudokuArr[x][y] = number;
+
+    if(previous > 0) {
+        this->refreshMasks(x, y, previous);
+    }
+
+    if(number > 0) {
+        Mask bit = (Mask) 1 << (number - 1);
+        this->rowMask[x] |= bit;
+        this->colMask[y] |= bit;
+        this->boxMask[boxIndex(x, y)] |= bit;
+    }
+}
+
+// Clears the bit of number in the units of the given cell unless another cell still holds it
+// (boards filled by the player may contain duplicates)
+template <int BoxN>
+void BasicSudoku<BoxN>::refreshMasks(int row, int col, int number) {
+    bool inRow = false, inCol = false, inBox = false;
+    int startRow = row - row % BoxN;
+    int startCol = col - col % BoxN;
+
+    for(int i = 0; i < SIZE; i++) {
+        if(this->sudokuArr[row][i] == number) inRow = true;
+        if(this->sudokuArr[i][col] == number) inCol = true;
+        if(this->sudokuArr[startRow + i / BoxN][startCol + i % BoxN] == number) inBox = true;
+    }
+
+    Mask bit = (Mask) 1 << (number - 1);
+    if(!inRow) this->rowMask[row] &= ~bit;
+    if(!inCol) this->colMask[col] &= ~bit;
+    if(!inBox) this->boxMask[boxIndex(row, col)] &= ~bit;
+}
+
+/**
+ * 
+ * --------------------- SUDOKU GENERATOR FUNCTIONS ---------------------
+ * 
+*/
+
+template <int BoxN>
+int BasicSudoku<BoxN>::countBlank() {
     int blankSum = 0;
-    for(int i = 0; i < 9; i++) {
-        for(int j = 0; j < 9; j++) {
+    for(int i = 0; i < SIZE; i++) {
+        for(int j = 0; j < SIZE; j++) {
             if(this->sudokuArr[i][j] == 0) {
                 blankSum += 1;
             }
@@ -125,13 +363,16 @@ int Sudoku::countBlank() {
     return blankSum;
 }
 
-void Sudoku::generateSudoku(int level) {
+template <int BoxN>
+void BasicSudoku<BoxN>::generateSudoku(int level, Random &random, bool minimal) {
     // level Easy (0) -> 40 blankFields
-    // level Medium (1) -> 50 blankFields
-    // level Hard (2) -> 60 blankFields
+    // level Medium (1) -> 53 blankFields
+    // level Hard (2) -> 63 blankFields
+    // (out of 81, other sizes use the same share of their cells)
 
-    // In reality those numbers are approximate values representing blank fields in the puzzle
-    // depending on choosen level
+    // Clues are only removed while the puzzle keeps a single solution, so those numbers are
+    // upper bounds - a Hard puzzle usually runs out of removable clues before reaching 63.
+    // A minimal puzzle keeps removing until no clue can be taken away anymore.
 
     int blankFieldsCount = 0;
     switch (level) {
@@ -149,20 +390,43 @@ void Sudoku::generateSudoku(int level) {
             break;
     }
 
-    srand((unsigned int) time (NULL));
-    for(int i = 0; i < blankFieldsCount + 10; i++) {
-        int randomRow = rand()%9;
-        int randomCol = rand()%9;
-        this->sudokuArr[randomRow][randomCol] = 0;
+    blankFieldsCount = blankFieldsCount * CELLS / 81;
 
-        if(this->countBlank() > blankFieldsCount) {
-            break;
-        }
+    if(minimal) {
+        blankFieldsCount = CELLS;
     }
-}
 
-Sudoku* Sudoku::copySudoku() {
-    return new Sudoku(this->sudokuArr);
-}
+    // Every cell is tried once, in random order
+    int cells[CELLS];
+    for(int i = 0; i < CELLS; i++) { cells[i] = i; }
+
+    for(int i = CELLS - 1; i > 0; i--) {
+        int j = random.below(i + 1);
+        int tmp = cells[i];
+        cells[i] = cells[j];
+        cells[j] = tmp;
+    }
+
+    int blank = this->countBlank();
+    for(int i = 0; i < CELLS && blank < blankFieldsCount; i++) {
+        int row = cells[i] / SIZE;
+        int col = cells[i] % SIZE;
+        int number = this->sudokuArr[row][col];
+
+        if(number == 0) continue;
 
+        this->removeNumber(row, col);
+        STATS_ADD(removalAttempts, 1);
+        if(this->countSolutions(2) == 1) {
+            STATS_ADD(removals, 1);
+            blank++;
+        } else {
+            this->placeNumber(row, col, number);
+        }
+    }
+}
 
+template class BasicSudoku<2>;
+template class BasicSudoku<3>;
+template class BasicSudoku<4>;
+template class BasicSudoku<5>;
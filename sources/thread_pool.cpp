@@ -0,0 +1,121 @@
+#include "../headers/thread_pool.h"
+
+// Pool and index of the worker running on the current thread
+static thread_local ThreadPool *currentPool = NULL;
+static thread_local int currentIndex = -1;
+
+ThreadPool::ThreadPool(int threads) {
+    this->queued = 0;
+    this->pending = 0;
+    this->nextQueue = 0;
+    this->stopping = false;
+
+    if(threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+        if(threads <= 0) threads = 1;
+    }
+
+    for(int i = 0; i < threads; i++) {
+        this->queues.push_back(new WorkQueue());
+    }
+    for(int i = 0; i < threads; i++) {
+        this->workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->taskAdded.notify_all();
+
+    for(size_t i = 0; i < this->workers.size(); i++) {
+        this->workers[i].join();
+    }
+    for(size_t i = 0; i < this->queues.size(); i++) {
+        delete this->queues[i];
+    }
+}
+
+int ThreadPool::getSize() {
+    return this->workers.size();
+}
+
+int ThreadPool::getWorkerIndex() {
+    return currentPool == this ? currentIndex : -1;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int index = this->getWorkerIndex();
+    if(index < 0) {
+        index = this->nextQueue.fetch_add(1) % this->queues.size();
+    }
+
+    this->pending++;
+    {
+        std::unique_lock<std::mutex> guard(this->queues[index]->lock);
+        this->queues[index]->tasks.push_back(task);
+    }
+    this->queued++;
+
+    // Taking the lock makes sure a worker going to sleep has either seen the task or is already waiting
+    { std::unique_lock<std::mutex> guard(this->lock); }
+    this->taskAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    while(this->pending > 0) {
+        this->taskDone.wait(guard);
+    }
+}
+
+// Own deque first (newest task), then the oldest task of the other workers
+bool ThreadPool::takeTask(int index, std::function<void()> &task) {
+    int count = this->queues.size();
+
+    for(int i = 0; i < count; i++) {
+        WorkQueue *queue = this->queues[(index + i) % count];
+        std::unique_lock<std::mutex> guard(queue->lock);
+
+        if(queue->tasks.empty()) continue;
+
+        if(i == 0) {
+            task = queue->tasks.back();
+            queue->tasks.pop_back();
+        } else {
+            task = queue->tasks.front();
+            queue->tasks.pop_front();
+        }
+        this->queued--;
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(int index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while(1) {
+        std::function<void()> task;
+
+        if(this->takeTask(index, task)) {
+            task();
+
+            if(--this->pending == 0) {
+                std::unique_lock<std::mutex> guard(this->lock);
+                this->taskDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(this->lock);
+        while(this->queued == 0 && !this->stopping) {
+            this->taskAdded.wait(guard);
+        }
+        if(this->queued == 0 && this->stopping) return;
+    }
+}
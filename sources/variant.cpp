@@ -0,0 +1,355 @@
+#include "../headers/variant.h"
+#include "../headers/stats.h"
+
+static const long RANDOM_NODES = 1 << 24;   // Random searches give up on rules without a solution past it
+static const long CHECK_INTERVAL = 256;     // Nodes between looks at the clock and the cancel token
+
+VariantSudoku::VariantSudoku(const RuleTables &rules) {
+    this->rules = &rules;
+    this->searchNodes = 0;
+    this->budget.nodes = 0;
+    this->budget.ms = 0;
+    this->budget.cancel = NULL;
+    this->stopped = SEARCH_SOLVED;
+    for(int i = 0; i < 81; i++) this->cells[i] = 0;
+    for(int u = 0; u < rules.unitCount; u++) this->refreshUnit(u);
+}
+
+// Recounts the mask, sum and empty cells of a unit from its cells
+void VariantSudoku::refreshUnit(int unit) {
+    Mask mask = 0;
+    int total = 0, empty = 0;
+
+    for(int k = 0; k < this->rules->unitSize[unit]; k++) {
+        int number = this->cells[this->rules->unitCells[unit][k]];
+        if(number == 0) {
+            empty++;
+        } else {
+            mask |= (Mask) 1 << (number - 1);
+            total += number;
+        }
+    }
+
+    this->unitMask[unit] = mask;
+    this->unitTotal[unit] = total > 255 ? 255 : total;
+    this->unitEmpty[unit] = empty;
+}
+
+bool VariantSudoku::loadString(const char *text) {
+    for(int i = 0; i < 81; i++) {
+        char c = text[i];
+        if(c >= '1' && c <= '9') {
+            this->cells[i] = c - '0';
+        } else if(c == '0' || c == '.') {
+            this->cells[i] = 0;
+        } else {
+            return false;
+        }
+    }
+
+    for(int u = 0; u < this->rules->unitCount; u++) this->refreshUnit(u);
+    return true;
+}
+
+void VariantSudoku::writeString(char *text) {
+    for(int i = 0; i < 81; i++) text[i] = '0' + this->cells[i];
+}
+
+int VariantSudoku::getItem(int row, int col) const {
+    return this->cells[row * 9 + col];
+}
+
+void VariantSudoku::setItem(int row, int col, int number) {
+    int cell = row * 9 + col;
+    this->cells[cell] = number;
+
+    for(int k = 0; k < this->rules->cellUnitCount[cell]; k++) this->refreshUnit(this->rules->cellUnits[cell][k]);
+    for(int k = 0; k < this->rules->cellCageCount[cell]; k++) this->refreshUnit(this->rules->cellCages[cell][k]);
+}
+
+// Numbers no unit of the cell holds yet that still fit the sums of its cages
+VariantSudoku::Mask VariantSudoku::getCandidates(int cell) {
+    const RuleTables &rules = *this->rules;
+    Mask used = 0;
+
+    for(int k = 0; k < rules.cellUnitCount[cell]; k++) used |= this->unitMask[rules.cellUnits[cell][k]];
+    Mask candidates = ~used & ALL;
+
+    for(int k = 0; k < rules.cellCageCount[cell]; k++) {
+        int cage = rules.cellCages[cell][k];
+        candidates &= getCageCandidates(this->unitMask[cage], this->unitEmpty[cage], rules.unitSum[cage] - this->unitTotal[cage]);
+    }
+
+    return candidates;
+}
+
+bool VariantSudoku::isSafe(int row, int col, int number) {
+    STATS_ADD(isSafeCalls, 1);
+    return (this->getCandidates(row * 9 + col) & ((Mask) 1 << (number - 1))) != 0;
+}
+
+// Solver-only assignment, the cell has to be empty and the number one of its candidates
+void VariantSudoku::placeNumber(int cell, int number) {
+    const RuleTables &rules = *this->rules;
+    Mask bit = (Mask) 1 << (number - 1);
+    this->cells[cell] = number;
+
+    for(int k = 0; k < rules.cellUnitCount[cell]; k++) this->unitMask[rules.cellUnits[cell][k]] |= bit;
+    for(int k = 0; k < rules.cellCageCount[cell]; k++) {
+        int cage = rules.cellCages[cell][k];
+        this->unitMask[cage] |= bit;
+        this->unitTotal[cage] += number;
+        this->unitEmpty[cage]--;
+    }
+}
+
+void VariantSudoku::removeNumber(int cell) {
+    const RuleTables &rules = *this->rules;
+    int number = this->cells[cell];
+    Mask bit = (Mask) 1 << (number - 1);
+    this->cells[cell] = 0;
+
+    for(int k = 0; k < rules.cellUnitCount[cell]; k++) this->unitMask[rules.cellUnits[cell][k]] &= ~bit;
+    for(int k = 0; k < rules.cellCageCount[cell]; k++) {
+        int cage = rules.cellCages[cell][k];
+        this->unitMask[cage] &= ~bit;
+        this->unitTotal[cage] -= number;
+        this->unitEmpty[cage]++;
+    }
+}
+
+// Finds the empty cell with the fewest candidates, like Sudoku::findConstrainedCell.
+// Returns 1 when found, 0 when the board is full and -1 when some cell has no candidates left
+int VariantSudoku::findConstrainedCell(int &cell, Mask &candidates) {
+    Mask fits[81];
+    int best = 10;
+
+    for(int i = 0; i < 81; i++) {
+        if(this->cells[i] > 0) {
+            fits[i] = 0;
+            continue;
+        }
+
+        fits[i] = this->getCandidates(i);
+        int count = __builtin_popcount(fits[i]);
+
+        if(count < best) {
+            best = count;
+            cell = i;
+            candidates = fits[i];
+            if(count <= 1) return count == 0 ? -1 : 1;
+        }
+    }
+
+    if(best == 10) return 0;
+
+    // Irregular regions and cages leave cells with more candidates than the classic rules,
+    // a number that fits only one cell of a full unit is forced just like a single candidate
+    return this->findHiddenSingle(fits, cell, candidates);
+}
+
+// Looks for a unit of 9 cells where some missing number fits a single cell, given the candidates
+// of every cell. Returns -1 when a missing number fits nowhere, otherwise 1 (cell and candidates
+// only change when a single is found)
+int VariantSudoku::findHiddenSingle(const Mask fits[81], int &cell, Mask &candidates) {
+    const RuleTables &rules = *this->rules;
+
+    for(int u = 0; u < rules.unitCount; u++) {
+        if(rules.unitSize[u] != 9) continue;
+
+        Mask missing = ALL & ~this->unitMask[u];
+        if(missing == 0) continue;
+
+        const uint8_t *unit = rules.unitCells[u];
+        Mask once = 0, twice = 0;
+        for(int k = 0; k < 9; k++) {
+            twice |= once & fits[unit[k]];
+            once |= fits[unit[k]];
+        }
+
+        if(missing & ~once) return -1;
+
+        Mask single = once & ~twice;
+        if(single == 0) continue;
+
+        single &= -single;
+        for(int k = 0; k < 9; k++) {
+            if(fits[unit[k]] & single) {
+                cell = unit[k];
+                candidates = single;
+                return 1;
+            }
+        }
+    }
+
+    return 1;
+}
+
+// Records why the running search has to give up, if it has to
+bool VariantSudoku::isOutOfBudget() {
+    if(this->stopped != SEARCH_SOLVED) return true;
+
+    if(this->budget.nodes > 0 && this->searchNodes >= this->budget.nodes) {
+        this->stopped = SEARCH_BUDGET;
+    } else if(this->searchNodes % CHECK_INTERVAL == 0) {
+        if(this->budget.cancel != NULL && this->budget.cancel->isCancelled()) {
+            this->stopped = SEARCH_CANCELLED;
+        } else if(this->budget.ms > 0 && std::chrono::steady_clock::now() >= this->deadline) {
+            this->stopped = SEARCH_BUDGET;
+        }
+    }
+
+    return this->stopped != SEARCH_SOLVED;
+}
+
+// With random, the numbers of every cell are tried from a random one on
+bool VariantSudoku::solveConstrained(int depth, Random *random) {
+    int cell;
+    Mask candidates;
+    int found = this->findConstrainedCell(cell, candidates);
+
+    if(found == 0) return true;
+    if(found < 0) return false;
+    if(this->isOutOfBudget()) return false;
+
+    STATS_MAX(maxDepth, depth + 1);
+
+    int shift = random != NULL ? random->below(9) : 0;
+    Mask order = ((candidates >> shift) | (candidates << (9 - shift))) & ALL;
+
+    while(order && this->stopped == SEARCH_SOLVED) {
+        int number = (__builtin_ctz(order) + shift) % 9 + 1;
+        order &= order - 1;
+
+        this->placeNumber(cell, number);
+        this->searchNodes++;
+        STATS_ADD(nodes, 1);
+        if(this->solveConstrained(depth + 1, random)) return true;
+        this->removeNumber(cell);
+        STATS_ADD(backtracks, 1);
+    }
+
+    return false;
+}
+
+bool VariantSudoku::isValid() {
+    const RuleTables &rules = *this->rules;
+
+    for(int i = 0; i < 81; i++) {
+        if(this->cells[i] == 0) continue;
+        for(int k = 0; k < rules.peerCount[i]; k++) {
+            if(this->cells[rules.peers[i][k]] == this->cells[i]) return false;
+        }
+    }
+
+    for(int u = 0; u < rules.unitCount; u++) {
+        if(rules.unitSum[u] == 0) continue;
+        if(this->unitTotal[u] > rules.unitSum[u]) return false;
+        if(this->unitEmpty[u] == 0 && this->unitTotal[u] != rules.unitSum[u]) return false;
+    }
+
+    return true;
+}
+
+bool VariantSudoku::solve() {
+    SearchBudget unlimited = { 0, 0, NULL };
+    return this->solveBounded(unlimited) == SEARCH_SOLVED;
+}
+
+SearchResult VariantSudoku::solveBounded(const SearchBudget &budget) {
+    // Conflicting givens would otherwise make the search exhaust the whole tree
+    if(!this->isValid()) return SEARCH_UNSOLVABLE;
+    if(budget.cancel != NULL && budget.cancel->isCancelled()) return SEARCH_CANCELLED;
+
+    this->searchNodes = 0;
+    this->budget = budget;
+    this->deadline = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(budget.ms));
+    this->stopped = SEARCH_SOLVED;
+
+    bool solved = this->solveConstrained(0, NULL);
+    SearchResult result = solved ? SEARCH_SOLVED : this->stopped != SEARCH_SOLVED ? this->stopped : SEARCH_UNSOLVABLE;
+
+    this->budget.nodes = 0;
+    this->budget.ms = 0;
+    this->budget.cancel = NULL;
+    this->stopped = SEARCH_SOLVED;
+    return result;
+}
+
+// Irregular regions make some random fillings run into huge dead subtrees early on, so the search
+// starts over with other random choices after a node limit that doubles every time
+bool VariantSudoku::solveRandom(Random &random) {
+    if(!this->isValid()) return false;
+
+    long total = 0;
+    bool solved = false;
+    for(long limit = 1000; limit <= RANDOM_NODES; limit *= 2) {
+        this->searchNodes = 0;
+        this->budget.nodes = limit;
+        this->stopped = SEARCH_SOLVED;
+        STATS_ADD(gridAttempts, 1);
+
+        solved = this->solveConstrained(0, &random);
+        total += this->searchNodes;
+
+        // Done unless it ran out of nodes
+        if(solved || this->stopped == SEARCH_SOLVED) break;
+    }
+
+    this->budget.nodes = 0;
+    this->stopped = SEARCH_SOLVED;
+    this->searchNodes = total;
+    return solved;
+}
+
+// Counts solutions of the current board, stopping as soon as limit is reached.
+// The board is left unchanged
+int VariantSudoku::countSolutions(int limit) {
+    this->searchNodes = 0;
+    if(!this->isValid()) return 0;
+
+    int count = 0;
+    this->countConstrained(count, limit, 0);
+    return count;
+}
+
+void VariantSudoku::countConstrained(int &count, int limit, int depth) {
+    int cell;
+    Mask candidates;
+    int found = this->findConstrainedCell(cell, candidates);
+
+    if(found == 0) {
+        count++;
+        return;
+    }
+    if(found < 0) return;
+
+    STATS_MAX(maxDepth, depth + 1);
+
+    while(candidates && count < limit) {
+        int number = __builtin_ctz(candidates) + 1;
+        candidates &= candidates - 1;
+
+        this->placeNumber(cell, number);
+        this->searchNodes++;
+        STATS_ADD(nodes, 1);
+        this->countConstrained(count, limit, depth + 1);
+        this->removeNumber(cell);
+        STATS_ADD(backtracks, 1);
+    }
+}
+
+long VariantSudoku::getSearchNodes() {
+    return this->searchNodes;
+}
+
+int VariantSudoku::countBlank() {
+    int blank = 0;
+    for(int i = 0; i < 81; i++) blank += this->cells[i] == 0;
+    return blank;
+}
+
+const RuleTables& VariantSudoku::getRules() const {
+    return *this->rules;
+}
@@ -0,0 +1,537 @@
+#include "../headers/verify.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VERIFY_X86
+#endif
+
+static const int LANES = 32;                    // Boards per block, one AVX2 register of bytes
+static const size_t IO_BLOCK = 1 << 20;         // Size of the buffered reads and writes
+
+/**
+ * Boards of a block as a structure of arrays: byte lane b of every cell belongs to board b.
+ * Solutions hold 1..9, any other character becomes 0 and fails its units. Givens are 0 for
+ * blank cells and 0xFF for characters that can't be a given, which never match a solution.
+*/
+struct VerifyBlock {
+    alignas(32) uint8_t solution[81][LANES];
+    alignas(32) uint8_t given[81][LANES];
+    const char *solutionText[LANES];    // Where the 81 cells of the boards are in the input
+    const char *givenText[LANES];
+    long line[LANES];                   // Input line of every board
+    int boards;
+    bool givens;                        // Whether any board has a puzzle, given is all 0 otherwise
+};
+
+static const int TILES = 5;             // Cells 0..79 are loaded 16 at a time, cell 80 on its own
+
+// Text of a missing puzzle (no givens) and of the unused lanes of the last block
+static const char BLANK_TEXT[82] =
+    ".................................................................................";
+
+// Cells of the 27 units: rows, columns, then boxes
+struct Units {
+    uint8_t cells[27][9];
+
+    Units() {
+        for(int u = 0; u < 9; u++) {
+            for(int k = 0; k < 9; k++) {
+                this->cells[u][k] = u * 9 + k;
+                this->cells[9 + u][k] = k * 9 + u;
+                this->cells[18 + u][k] = ((u / 3) * 3 + k / 3) * 9 + (u % 3) * 3 + k % 3;
+            }
+        }
+    }
+};
+
+static const Units UNITS;
+
+// Fills one cell of every lane of a block
+static void loadCell(VerifyBlock &b, int i) {
+    for(int lane = 0; lane < LANES; lane++) {
+        char c = b.solutionText[lane][i];
+        b.solution[i][lane] = c >= '1' && c <= '9' ? c - '0' : 0;
+
+        c = b.givenText[lane][i];
+        b.given[i][lane] = c >= '1' && c <= '9' ? c - '0' : (c == '0' || c == '.') ? 0 : 0xFF;
+    }
+}
+
+#ifdef VERIFY_X86
+
+// Transposes 16 rows of 16 bytes in place. Each round interleaves row i with row i + 8, which
+// rotates the 4 row and 4 column bits of every byte's position by one, so 4 rounds swap them
+static void transpose16(__m128i rows[16]) {
+    for(int round = 0; round < 4; round++) {
+        __m128i next[16];
+        for(int i = 0; i < 8; i++) {
+            next[2 * i] = _mm_unpacklo_epi8(rows[i], rows[i + 8]);
+            next[2 * i + 1] = _mm_unpackhi_epi8(rows[i], rows[i + 8]);
+        }
+        for(int i = 0; i < 16; i++) rows[i] = next[i];
+    }
+}
+
+// Fills the arrays of a block from the text of its boards, 16 boards by 16 cells at a time
+static void loadBlock(VerifyBlock &b) {
+    const __m128i zeroChar = _mm_set1_epi8('0');
+    const __m128i dot = _mm_set1_epi8('.');
+    const __m128i eight = _mm_set1_epi8(8);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i full = _mm_set1_epi8((char) 0xFF);
+
+    if(!b.givens) memset(b.given, 0, sizeof(b.given));
+
+    for(int half = 0; half < LANES / 16; half++) {
+        for(int tile = 0; tile < TILES; tile++) {
+            __m128i solution[16];
+            __m128i given[16];
+            for(int k = 0; k < 16; k++) {
+                solution[k] = _mm_loadu_si128((const __m128i*) (b.solutionText[half * 16 + k] + tile * 16));
+            }
+            transpose16(solution);
+
+            for(int k = 0; k < 16; k++) {
+                // Digits 1..9 are the bytes with number - 1 <= 8 unsigned
+                __m128i number = _mm_sub_epi8(solution[k], zeroChar);
+                __m128i minus = _mm_sub_epi8(number, one);
+                __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(minus, eight), minus);
+                _mm_store_si128((__m128i*) &b.solution[tile * 16 + k][half * 16], _mm_and_si128(number, digit));
+            }
+
+            if(!b.givens) continue;
+
+            for(int k = 0; k < 16; k++) {
+                given[k] = _mm_loadu_si128((const __m128i*) (b.givenText[half * 16 + k] + tile * 16));
+            }
+            transpose16(given);
+
+            for(int k = 0; k < 16; k++) {
+                __m128i number = _mm_sub_epi8(given[k], zeroChar);
+                __m128i minus = _mm_sub_epi8(number, one);
+                __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(minus, eight), minus);
+                __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(given[k], zeroChar), _mm_cmpeq_epi8(given[k], dot));
+                __m128i value = _mm_or_si128(_mm_and_si128(number, digit), _mm_andnot_si128(_mm_or_si128(digit, blank), full));
+                _mm_store_si128((__m128i*) &b.given[tile * 16 + k][half * 16], value);
+            }
+        }
+    }
+    loadCell(b, 80);
+}
+
+// Same transpose with board k of both halves in the two 128-bit lanes of row k, which the
+// unpacks keep apart, so one pass does all 32 boards
+__attribute__((target("avx2")))
+static void transpose16x2(__m256i rows[16]) {
+    for(int round = 0; round < 4; round++) {
+        __m256i next[16];
+        for(int i = 0; i < 8; i++) {
+            next[2 * i] = _mm256_unpacklo_epi8(rows[i], rows[i + 8]);
+            next[2 * i + 1] = _mm256_unpackhi_epi8(rows[i], rows[i + 8]);
+        }
+        for(int i = 0; i < 16; i++) rows[i] = next[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void loadBlockAvx2(VerifyBlock &b) {
+    const __m256i zeroChar = _mm256_set1_epi8('0');
+    const __m256i dot = _mm256_set1_epi8('.');
+    const __m256i eight = _mm256_set1_epi8(8);
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i full = _mm256_set1_epi8((char) 0xFF);
+
+    if(!b.givens) memset(b.given, 0, sizeof(b.given));
+
+    for(int tile = 0; tile < TILES; tile++) {
+        __m256i solution[16];
+        __m256i given[16];
+        for(int k = 0; k < 16; k++) {
+            solution[k] = _mm256_loadu2_m128i((const __m128i*) (b.solutionText[16 + k] + tile * 16),
+                (const __m128i*) (b.solutionText[k] + tile * 16));
+        }
+        transpose16x2(solution);
+
+        for(int k = 0; k < 16; k++) {
+            __m256i number = _mm256_sub_epi8(solution[k], zeroChar);
+            __m256i minus = _mm256_sub_epi8(number, one);
+            __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(minus, eight), minus);
+            _mm256_store_si256((__m256i*) b.solution[tile * 16 + k], _mm256_and_si256(number, digit));
+        }
+
+        if(!b.givens) continue;
+
+        for(int k = 0; k < 16; k++) {
+            given[k] = _mm256_loadu2_m128i((const __m128i*) (b.givenText[16 + k] + tile * 16),
+                (const __m128i*) (b.givenText[k] + tile * 16));
+        }
+        transpose16x2(given);
+
+        for(int k = 0; k < 16; k++) {
+            __m256i number = _mm256_sub_epi8(given[k], zeroChar);
+            __m256i minus = _mm256_sub_epi8(number, one);
+            __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(minus, eight), minus);
+            __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(given[k], zeroChar), _mm256_cmpeq_epi8(given[k], dot));
+            __m256i value = _mm256_or_si256(_mm256_and_si256(number, digit), _mm256_andnot_si256(_mm256_or_si256(digit, blank), full));
+            _mm256_store_si256((__m256i*) b.given[tile * 16 + k], value);
+        }
+    }
+    loadCell(b, 80);
+}
+
+#else
+
+static void loadBlock(VerifyBlock &b) {
+    for(int i = 0; i < 81; i++) loadCell(b, i);
+}
+
+#endif
+
+// Every kernel returns a bit per lane of the boards that failed
+
+typedef uint32_t (*VerifyKernel)(const VerifyBlock &block);
+typedef void (*BlockLoader)(VerifyBlock &block);
+
+static uint32_t verifyScalar(const VerifyBlock &b) {
+    uint32_t failed = 0;
+
+    for(int lane = 0; lane < LANES; lane++) {
+        bool valid = true;
+
+        for(int u = 0; u < 27; u++) {
+            uint16_t seen = 0;
+            for(int k = 0; k < 9; k++) {
+                seen |= 1 << b.solution[UNITS.cells[u][k]][lane];
+            }
+            if(seen != 0x3FE) valid = false;
+        }
+
+        for(int i = 0; i < 81; i++) {
+            uint8_t given = b.given[i][lane];
+            if(given != 0 && given != b.solution[i][lane]) valid = false;
+        }
+
+        if(!valid) failed |= 1u << lane;
+    }
+
+    return failed;
+}
+
+#ifdef VERIFY_X86
+
+// Byte shuffles turning a number into its bit: numbers 1..8 into the low mask, 9 into the high one
+#define VERIFY_LOW_BITS 0, 1, 2, 4, 8, 16, 32, 64, (char) 128, 0, 0, 0, 0, 0, 0, 0
+#define VERIFY_HIGH_BITS 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0
+
+__attribute__((target("ssse3")))
+static uint32_t verifySsse3(const VerifyBlock &b) {
+    const __m128i lowBits = _mm_setr_epi8(VERIFY_LOW_BITS);
+    const __m128i highBits = _mm_setr_epi8(VERIFY_HIGH_BITS);
+    const __m128i full = _mm_set1_epi8((char) 0xFF);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t failed = 0;
+
+    for(int half = 0; half < 2; half++) {
+        __m128i valid = full;
+
+        for(int u = 0; u < 27; u++) {
+            __m128i low = zero;
+            __m128i high = zero;
+            for(int k = 0; k < 9; k++) {
+                __m128i number = _mm_load_si128((const __m128i*) &b.solution[UNITS.cells[u][k]][half * 16]);
+                low = _mm_or_si128(low, _mm_shuffle_epi8(lowBits, number));
+                high = _mm_or_si128(high, _mm_shuffle_epi8(highBits, number));
+            }
+            valid = _mm_and_si128(valid, _mm_and_si128(_mm_cmpeq_epi8(low, full), _mm_cmpeq_epi8(high, one)));
+        }
+
+        for(int i = 0; i < 81; i++) {
+            __m128i given = _mm_load_si128((const __m128i*) &b.given[i][half * 16]);
+            __m128i number = _mm_load_si128((const __m128i*) &b.solution[i][half * 16]);
+            valid = _mm_and_si128(valid, _mm_or_si128(_mm_cmpeq_epi8(given, zero), _mm_cmpeq_epi8(given, number)));
+        }
+
+        failed |= (uint32_t) (~_mm_movemask_epi8(valid) & 0xFFFF) << (16 * half);
+    }
+
+    return failed;
+}
+
+__attribute__((target("avx2")))
+static uint32_t verifyAvx2(const VerifyBlock &b) {
+    const __m256i lowBits = _mm256_setr_epi8(VERIFY_LOW_BITS, VERIFY_LOW_BITS);
+    const __m256i highBits = _mm256_setr_epi8(VERIFY_HIGH_BITS, VERIFY_HIGH_BITS);
+    const __m256i full = _mm256_set1_epi8((char) 0xFF);
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i valid = full;
+
+    for(int u = 0; u < 27; u++) {
+        __m256i low = zero;
+        __m256i high = zero;
+        for(int k = 0; k < 9; k++) {
+            __m256i number = _mm256_load_si256((const __m256i*) b.solution[UNITS.cells[u][k]]);
+            low = _mm256_or_si256(low, _mm256_shuffle_epi8(lowBits, number));
+            high = _mm256_or_si256(high, _mm256_shuffle_epi8(highBits, number));
+        }
+        valid = _mm256_and_si256(valid, _mm256_and_si256(_mm256_cmpeq_epi8(low, full), _mm256_cmpeq_epi8(high, one)));
+    }
+
+    for(int i = 0; i < 81; i++) {
+        __m256i given = _mm256_load_si256((const __m256i*) b.given[i]);
+        __m256i number = _mm256_load_si256((const __m256i*) b.solution[i]);
+        valid = _mm256_and_si256(valid, _mm256_or_si256(_mm256_cmpeq_epi8(given, zero), _mm256_cmpeq_epi8(given, number)));
+    }
+
+    return ~(uint32_t) _mm256_movemask_epi8(valid);
+}
+
+#endif
+
+struct KernelChoice {
+    VerifyKernel kernel;
+    BlockLoader load;
+    const char *name;
+};
+
+static KernelChoice detectKernel() {
+    KernelChoice choice = {verifyScalar, loadBlock, "scalar"};
+
+#ifdef VERIFY_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        choice.kernel = verifyAvx2;
+        choice.load = loadBlockAvx2;
+        choice.name = "avx2";
+    } else if(__builtin_cpu_supports("ssse3")) {
+        choice.kernel = verifySsse3;
+        choice.load = loadBlock;
+        choice.name = "ssse3";
+    }
+#endif
+
+    return choice;
+}
+
+static KernelChoice& currentKernel() {
+    static KernelChoice choice = detectKernel();
+    return choice;
+}
+
+const char* getVerifyKernel() {
+    return currentKernel().name;
+}
+
+bool setVerifyKernel(const char *name) {
+    KernelChoice &choice = currentKernel();
+
+    if(strcmp(name, "scalar") == 0) {
+        choice.kernel = verifyScalar;
+        choice.load = loadBlock;
+        choice.name = "scalar";
+        return true;
+    }
+
+#ifdef VERIFY_X86
+    if(strcmp(name, "ssse3") == 0 && __builtin_cpu_supports("ssse3")) {
+        choice.kernel = verifySsse3;
+        choice.load = loadBlock;
+        choice.name = "ssse3";
+        return true;
+    }
+    if(strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        choice.kernel = verifyAvx2;
+        choice.load = loadBlockAvx2;
+        choice.name = "avx2";
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+static const char *UNIT_NAMES[3] = {"row", "column", "box"};
+
+// Checks one board of the block again cell by cell and appends what is wrong with it
+static void describeFailure(const VerifyBlock &b, int lane, std::string &report) {
+    char text[96];
+    snprintf(text, sizeof(text), "line %ld:", b.line[lane]);
+    report += text;
+
+    const char *separator = " ";
+    for(int i = 0; i < 81; i++) {
+        if(b.solution[i][lane] == 0) {
+            snprintf(text, sizeof(text), "%scell %d,%d isn't 1-9", separator, i / 9 + 1, i % 9 + 1);
+            report += text;
+            separator = "; ";
+        }
+    }
+
+    for(int u = 0; u < 27; u++) {
+        int first[10];
+        for(int number = 0; number < 10; number++) first[number] = -1;
+
+        for(int k = 0; k < 9; k++) {
+            int cell = UNITS.cells[u][k];
+            int number = b.solution[cell][lane];
+            if(number == 0) continue;
+
+            if(first[number] < 0) {
+                first[number] = cell;
+            } else if(first[number] < 81) {
+                snprintf(text, sizeof(text), "%s%s %d repeats %d at %d,%d and %d,%d", separator,
+                    UNIT_NAMES[u / 9], u % 9 + 1, number, first[number] / 9 + 1, first[number] % 9 + 1, cell / 9 + 1, cell % 9 + 1);
+                report += text;
+                separator = "; ";
+                first[number] = 81;     // One report per number and unit
+            }
+        }
+    }
+
+    for(int i = 0; i < 81; i++) {
+        int given = b.given[i][lane];
+        if(given == 0 || given == b.solution[i][lane] || b.solution[i][lane] == 0) continue;
+
+        if(given == 0xFF) {
+            snprintf(text, sizeof(text), "%scell %d,%d has no valid given", separator, i / 9 + 1, i % 9 + 1);
+        } else {
+            snprintf(text, sizeof(text), "%scell %d,%d given %d, solution %d", separator, i / 9 + 1, i % 9 + 1, given, b.solution[i][lane]);
+        }
+        report += text;
+        separator = "; ";
+    }
+
+    report += '\n';
+}
+
+static bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == ';';
+}
+
+int runVerify(const std::string &path) {
+    FILE *input = path == "-" ? stdin : fopen(path.c_str(), "rb");
+    if(input == NULL) {
+        fprintf(stderr, "Can't open %s\n", path.c_str());
+        return 1;
+    }
+
+    setvbuf(stdout, NULL, _IOFBF, IO_BLOCK);
+
+    VerifyKernel kernel = currentKernel().kernel;
+    BlockLoader load = currentKernel().load;
+    VerifyBlock block;
+    block.boards = 0;
+    block.givens = false;
+
+    long lines = 0;
+    long boards = 0;
+    long failed = 0;
+    std::string report;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Checks the boards collected so far and reports the failed ones in input order
+    auto flushBlock = [&]() {
+        if(block.boards == 0) return;
+
+        for(int lane = block.boards; lane < LANES; lane++) {
+            block.solutionText[lane] = BLANK_TEXT;
+            block.givenText[lane] = BLANK_TEXT;
+        }
+        load(block);
+
+        uint32_t lanes = kernel(block);
+        if(block.boards < LANES) lanes &= (1u << block.boards) - 1;
+
+        while(lanes) {
+            int lane = __builtin_ctz(lanes);
+            lanes &= lanes - 1;
+            describeFailure(block, lane, report);
+            failed++;
+        }
+
+        boards += block.boards;
+        block.boards = 0;
+        block.givens = false;
+
+        if(report.size() >= IO_BLOCK) {
+            fwrite(report.data(), 1, report.size(), stdout);
+            report.clear();
+        }
+    };
+
+    auto addLine = [&](const char *text, size_t length) {
+        lines++;
+        if(length > 0 && text[length - 1] == '\r') length--;
+        if(length == 0) return;
+
+        const char *puzzle = NULL;
+        const char *solution = text;
+        if(length >= 163 && isSeparator(text[81]) && (length == 163 || isSeparator(text[163]))) {
+            puzzle = text;
+            solution = text + 82;
+        } else if(length != 81) {
+            flushBlock();
+            report += "line " + std::to_string(lines) + ": not a board\n";
+            boards++;
+            failed++;
+            return;
+        }
+
+        // The text stays in the buffer until the block is checked
+        int lane = block.boards++;
+        block.line[lane] = lines;
+        block.solutionText[lane] = solution;
+        block.givenText[lane] = puzzle != NULL ? puzzle : BLANK_TEXT;
+        if(puzzle != NULL) block.givens = true;
+
+        if(block.boards == LANES) flushBlock();
+    };
+
+    std::vector <char> buffer(IO_BLOCK);
+    size_t filled = 0;      // Bytes of the buffer holding a line not finished yet
+    size_t count;
+
+    while((count = fread(&buffer[filled], 1, IO_BLOCK - filled, input)) > 0) {
+        const char *cursor = &buffer[0];
+        const char *end = cursor + filled + count;
+        const char *newline;
+
+        while((newline = (const char*) memchr(cursor, '\n', end - cursor)) != NULL) {
+            addLine(cursor, newline - cursor);
+            cursor = newline + 1;
+        }
+
+        // The lines of the block are about to be moved
+        flushBlock();
+
+        filled = end - cursor;
+        if(filled == IO_BLOCK) {
+            // A line longer than the buffer can't be a board
+            addLine(cursor, filled);
+            filled = 0;
+        } else {
+            memmove(&buffer[0], cursor, filled);
+        }
+    }
+
+    if(filled > 0) addLine(&buffer[0], filled);
+    flushBlock();
+
+    fwrite(report.data(), 1, report.size(), stdout);
+    fflush(stdout);
+
+    if(input != stdin) fclose(input);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "Verified %ld boards in %.3f s (%.0f boards/s, %s): %ld failed\n",
+        boards, seconds, seconds > 0 ? boards / seconds : 0.0, getVerifyKernel(), failed);
+
+    return failed > 0 ? 1 : 0;
+}